@@ -0,0 +1,152 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "benchsupport.h"
+#include "librarysnapshot.h"
+#include "photocontroller.h"
+#include "thumbnaildiskcache.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QTextStream>
+#include <QTimer>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace BenchSupport {
+
+qint64 peakResidentBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return qint64(counters.PeakWorkingSetSize);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(Q_OS_MACOS)
+    return qint64(usage.ru_maxrss); // bytes
+#else
+    return qint64(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+qint64 residentBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return qint64(counters.WorkingSetSize);
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, task_info_t(&info), &count) != KERN_SUCCESS) return -1;
+    return qint64(info.resident_size);
+#else
+    // Second field of statm is the resident set in pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+bool waitFor(const std::function<bool()> &done, qint64 timeoutMsecs) {
+    QElapsedTimer timer;
+    timer.start();
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (done() || timer.elapsed() > timeoutMsecs) loop.quit();
+    });
+    poll.start(2);
+    if (!done()) loop.exec();
+    return done();
+}
+
+qint64 histogramCount(const Metrics::Histogram &histogram) {
+    qint64 count = 0;
+    for (int64_t bucket : histogram)
+        count += bucket;
+    return count;
+}
+
+Metrics::Histogram histogramSince(Metrics::Latency latency, const Metrics::Histogram &before) {
+    Metrics::Histogram histogram = Metrics::histogram(latency);
+    for (int bucket = 0; bucket < Metrics::Buckets; ++bucket)
+        histogram[bucket] -= before[bucket];
+    return histogram;
+}
+
+QString seedSettings(const QString &directory, const QString &thumbnailBudgetMegabytes) {
+    const QString settingsPath = directory + QStringLiteral("/settings.ini");
+    QSettings seed(settingsPath, QSettings::IniFormat);
+    seed.setValue("rootFolder", "");
+    seed.setValue("openedDirectory", "");
+    seed.setValue("gallerySortMode", "date");
+    seed.setValue("galleryTargetWidth", 200);
+    seed.setValue("thumbnailMemoryBudget", thumbnailBudgetMegabytes);
+    return settingsPath;
+}
+
+void clearCaches() {
+    QDir(LibrarySnapshot::location()).removeRecursively();
+    QDir(ThumbnailDiskCache::location()).removeRecursively();
+}
+
+bool scan(PhotoController &controller, const QString &root, qint64 timeoutMsecs) {
+    bool scanned = false;
+    const QMetaObject::Connection connection = QObject::connect(&controller, &PhotoController::scanFinished, [&scanned]() { scanned = true; });
+    controller.setRootFolder(root);
+    const bool finished = waitFor([&]() { return scanned; }, timeoutMsecs);
+    QObject::disconnect(connection);
+    return finished;
+}
+
+bool waitForMetadata(const Metrics::Histogram &exifBefore, int photos, qint64 timeoutMsecs) {
+    return waitFor([&]() { return histogramCount(histogramSince(Metrics::ExifRead, exifBefore)) >= photos; }, timeoutMsecs);
+}
+
+bool writeReport(const QJsonObject &report, const QString &outputPath) {
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+        return true;
+    }
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QTextStream(stderr) << "Could not write " << outputPath << "\n";
+        return false;
+    }
+    file.write(json);
+    return true;
+}
+
+} // namespace BenchSupport
@@ -0,0 +1,54 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "metrics.h"
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+
+class PhotoController;
+
+// Helpers shared by the benchmarks that drive the application headlessly
+namespace BenchSupport {
+
+qint64 peakResidentBytes(); // -1 where unknown
+qint64 residentBytes();     // current, -1 where unknown
+
+// Runs the event loop until done() holds, false on timeout
+bool waitFor(const std::function<bool()> &done, qint64 timeoutMsecs);
+
+qint64 histogramCount(const Metrics::Histogram &histogram);
+Metrics::Histogram histogramSince(Metrics::Latency latency, const Metrics::Histogram &before);
+
+// Writes the benchmark's own settings into directory: no root yet, date sort, default thumbnail size. Returns the file.
+QString seedSettings(const QString &directory, const QString &thumbnailBudgetMegabytes);
+
+// A snapshot of an earlier run would turn the scan into a reconciliation, cached thumbnails would skip decoding
+void clearCaches();
+
+// Opens root and runs the event loop until its walk has finished, false on timeout
+bool scan(PhotoController &controller, const QString &root, qint64 timeoutMsecs);
+// Until every photo's metadata has been read since exifBefore was taken, false on timeout
+bool waitForMetadata(const Metrics::Histogram &exifBefore, int photos, qint64 timeoutMsecs);
+
+// Indented JSON to outputPath, or to stdout if it is empty. False if the file cannot be written.
+bool writeReport(const QJsonObject &report, const QString &outputPath);
+
+} // namespace BenchSupport
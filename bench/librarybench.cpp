@@ -0,0 +1,166 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Drives PhotoController headlessly over a generated library and reports scan, EXIF, thumbnail and sort
+// throughput plus peak RSS as JSON, to compare builds against each other.
+// Usage: lysa-bench [--photos N] [--width N] [--height N] [--depth N] [--fanout N] [--png-percent N] [--seed N]
+//                   [--library DIR] [--output FILE] [--timeout SECONDS]
+
+#include "benchsupport.h"
+#include "syntheticlibrary.h"
+#include "photocontroller.h"
+#include "metrics.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace {
+
+QJsonObject phase(double seconds, int items) {
+    return {
+        { "seconds", seconds },
+        { "perSecond", seconds > 0 ? items / seconds : 0.0 }
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setOrganizationName("vorks");
+    QGuiApplication::setApplicationName("lysa-bench"); // caches apart from the application and lysa-scrollbench
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"photos", "Number of photos.", "n", "500"});
+    parser.addOption({"width", "Photo width.", "px", "1024"});
+    parser.addOption({"height", "Photo height.", "px", "768"});
+    parser.addOption({"depth", "Depth of the album tree.", "n", "3"});
+    parser.addOption({"fanout", "Subalbums per album.", "n", "3"});
+    parser.addOption({"png-percent", "Share of PNGs, the rest are JPEGs.", "n", "10"});
+    parser.addOption({"seed", "Seed of the generator.", "n", "1"});
+    parser.addOption({"library", "Generate into DIR, or reuse it if it already has photos.", "dir"});
+    parser.addOption({"output", "Write the JSON report to FILE instead of stdout.", "file"});
+    parser.addOption({"timeout", "Give up on a phase after this many seconds.", "seconds", "600"});
+    parser.process(app);
+
+    SyntheticLibraryOptions options;
+    options.photos = parser.value("photos").toInt();
+    options.width = parser.value("width").toInt();
+    options.height = parser.value("height").toInt();
+    options.depth = parser.value("depth").toInt();
+    options.fanout = parser.value("fanout").toInt();
+    options.pngPercent = parser.value("png-percent").toInt();
+    options.seed = parser.value("seed").toUInt();
+    const qint64 timeoutMsecs = parser.value("timeout").toLongLong() * 1000;
+
+    QTextStream err(stderr);
+    QTemporaryDir temp;
+    QString root = parser.value("library");
+    if (root.isEmpty()) root = temp.path() + QStringLiteral("/library");
+
+    QJsonObject report;
+    QElapsedTimer timer;
+
+    // Generation is reported but not part of any throughput
+    const bool reuse = QDir(root).exists() && !QDir(root).isEmpty();
+    if (!reuse) {
+        err << "Generating " << options.photos << " photos in " << root << "\n";
+        err.flush();
+        timer.start();
+        const SyntheticLibrary library = SyntheticLibrary::generate(root, options);
+        report.insert("generate", QJsonObject {
+            { "seconds", timer.nsecsElapsed() / 1e9 },
+            { "photos", int(library.files.size()) },
+            { "directories", int(library.directories.size()) },
+            { "bytes", library.bytes }
+        });
+    }
+    report.insert("options", QJsonObject {
+        { "library", root },
+        { "reused", reuse },
+        { "photos", options.photos },
+        { "width", options.width },
+        { "height", options.height },
+        { "depth", options.depth },
+        { "fanout", options.fanout },
+        { "pngPercent", options.pngPercent },
+        { "seed", qint64(options.seed) }
+    });
+
+    BenchSupport::clearCaches();
+
+    // Settings of their own, with a budget large enough for every thumbnail
+    AppSettings settings(BenchSupport::seedSettings(temp.path(), QStringLiteral("1024")));
+
+    bool failed = false;
+    {
+        PhotoController controller(&settings);
+        PhotoModel *model = controller.photoModel();
+        GalleryModel *gallery = controller.galleryModel();
+
+        // Scan, with EXIF extraction overlapping it like in the application
+        const Metrics::Histogram exifBefore = Metrics::histogram(Metrics::ExifRead);
+        timer.start();
+        failed |= !BenchSupport::scan(controller, root, timeoutMsecs);
+        const double scanSeconds = timer.nsecsElapsed() / 1e9;
+        const int photos = model->rowCount();
+        report.insert("scan", phase(scanSeconds, photos));
+
+        failed |= !BenchSupport::waitForMetadata(exifBefore, photos, timeoutMsecs);
+        QJsonObject exif = phase(timer.nsecsElapsed() / 1e9, photos);
+        exif.insert("latencyMsecs", QJsonObject::fromVariantMap(MetricsRegistry::percentiles(BenchSupport::histogramSince(Metrics::ExifRead, exifBefore))));
+        report.insert("exif", exif);
+
+        // Every thumbnail, as if the whole album was scrolled through
+        const qint64 thumbnailsBefore = Metrics::counter(Metrics::ThumbnailsGenerated);
+        const Metrics::Histogram decodeBefore = Metrics::histogram(Metrics::ThumbnailDecode);
+        timer.start();
+        for (int row = 0; row < photos; ++row)
+            model->loadThumbnail(row);
+        failed |= !BenchSupport::waitFor([&]() { return Metrics::counter(Metrics::ThumbnailsGenerated) - thumbnailsBefore >= photos; }, timeoutMsecs);
+        QJsonObject thumbnails = phase(timer.nsecsElapsed() / 1e9, photos);
+        thumbnails.insert("decodeMsecs", QJsonObject::fromVariantMap(MetricsRegistry::percentiles(BenchSupport::histogramSince(Metrics::ThumbnailDecode, decodeBefore))));
+        report.insert("thumbnails", thumbnails);
+
+        // Sorting runs on the GUI thread, so each mode is timed synchronously
+        QJsonObject sort;
+        for (const QString &mode : { QStringLiteral("name"), QStringLiteral("size"), QStringLiteral("camera"), QStringLiteral("date") }) {
+            timer.start();
+            gallery->setSortMode(mode);
+            sort.insert(mode, phase(timer.nsecsElapsed() / 1e9, photos));
+        }
+        report.insert("sort", sort);
+        report.insert("photos", photos);
+    }
+    BenchSupport::clearCaches();
+
+    report.insert("peakRssBytes", BenchSupport::peakResidentBytes());
+    report.insert("completed", !failed);
+
+    if (!BenchSupport::writeReport(report, parser.value("output"))) return 1;
+
+    if (failed) err << "A phase timed out, its numbers are incomplete\n";
+    return failed ? 1 : 0;
+}
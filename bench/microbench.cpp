@@ -0,0 +1,362 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+// QBENCHMARK micro-benchmarks of the hot paths, on fixture data that is the same on every run.
+// Usage: lysa-microbench [QtTest options, e.g. -median 5 or -tickcounter] [function[:row]...]
+
+#include "benchsupport.h"
+#include "syntheticlibrary.h"
+#include "appsettings.h"
+#include "directorymodel.h"
+#include "exifregistry.h"
+#include "gallerymodel.h"
+#include "photomodel.h"
+#include "photostore.h"
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QTemporaryDir>
+#include <QTest>
+#include <functional>
+#include <memory>
+#include <random>
+
+namespace {
+
+// lessThan() is what std::stable_sort calls per comparison
+class GalleryModelProbe : public GalleryModel {
+public:
+    using GalleryModel::GalleryModel;
+    using GalleryModel::lessThan;
+};
+
+// A row as PhotoModel kept it before PhotoStore, with its path index, for the memory comparison
+struct LegacyPhotoItem {
+    QString filePath;
+    QString thumbPath;
+    bool requested = false;
+    qint64 size = 0, modified = 0, created = 0;
+    ExifData exif;
+};
+
+} // namespace
+
+class HotPathBenchmarks : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void lessThan_data();
+    void lessThan();
+    void exifExtract();
+    void rationalFormatted_data();
+    void rationalFormatted();
+    void scaleThumbnail_data();
+    void scaleThumbnail();
+    void addDirectories_data();
+    void addDirectories();
+    void addPhotos_data();
+    void addPhotos();
+    void rowMemory_data();
+    void rowMemory();
+
+private:
+    static constexpr int SortRows = 20000;
+    static constexpr int AddedPhotos = 20000;
+    static constexpr int MemoryRows = 200000;
+
+    QTemporaryDir m_temp;
+    std::unique_ptr<AppSettings> m_settings;
+    SyntheticLibrary m_library;  // small photos with EXIF for extraction
+    QString m_largePhoto;        // full-size source for thumbnail scaling
+    QImage m_largeImage;
+};
+
+void HotPathBenchmarks::initTestCase() {
+    QVERIFY(m_temp.isValid());
+
+    // Defaults only, never the user's settings
+    m_settings = std::make_unique<AppSettings>(m_temp.path() + QStringLiteral("/settings.ini"));
+
+    SyntheticLibraryOptions small;
+    small.photos = 48;
+    small.width = 1024;
+    small.height = 768;
+    small.depth = 1;
+    small.fanout = 3;
+    small.pngPercent = 0;
+    m_library = SyntheticLibrary::generate(m_temp.path() + QStringLiteral("/library"), small);
+    QCOMPARE(int(m_library.files.size()), small.photos);
+
+    SyntheticLibraryOptions large;
+    large.photos = 1;
+    large.width = 4000;
+    large.height = 3000;
+    large.depth = 0;
+    large.pngPercent = 0;
+    large.seed = 2;
+    const SyntheticLibrary single = SyntheticLibrary::generate(m_temp.path() + QStringLiteral("/large"), large);
+    QCOMPARE(int(single.files.size()), 1);
+    m_largePhoto = single.files.first();
+    m_largeImage = QImageReader(m_largePhoto).read();
+    QVERIFY(!m_largeImage.isNull());
+}
+
+
+//----- GalleryModel::lessThan -----//
+
+void HotPathBenchmarks::lessThan_data() {
+    QTest::addColumn<QString>("mode");
+    for (const char *mode : { "date", "name", "size", "exposure", "camera", "iso", "focalLength" })
+        QTest::newRow(mode) << QString::fromLatin1(mode);
+}
+
+void HotPathBenchmarks::lessThan() {
+    QFETCH(QString, mode);
+
+    const QVector<PhotoFile> photos = SyntheticLibrary::photoFiles(QStringLiteral("/bench"), SortRows);
+    PhotoModel model(m_settings.get());
+    GalleryModelProbe gallery(m_settings.get(), model);
+    model.restoreMetadata(SyntheticLibrary::metadata(photos));
+    model.addPhotos(photos);
+    gallery.setSortMode(mode); // also builds the sort keys
+
+    // Fixed random pairs, a sort compares far apart rows just as often as neighbours
+    std::mt19937 rng(1);
+    std::vector<std::pair<int, int>> pairs(100000);
+    for (auto &pair : pairs)
+        pair = { int(rng() % SortRows), int(rng() % SortRows) };
+
+    int less = 0;
+    QBENCHMARK {
+        for (const auto &pair : pairs)
+            less += gallery.lessThan(pair.first, pair.second);
+    }
+    QVERIFY(less >= 0);
+}
+
+
+//----- ExifRegistry -----//
+
+void HotPathBenchmarks::exifExtract() {
+    // One iteration reads every fixture file, divide by their count for the cost per file
+    ExifRegistry registry;
+    int extracted = 0;
+    QBENCHMARK {
+        for (const QString &file : m_library.files) {
+            ExifData data;
+            extracted += registry.extract(file, data);
+        }
+    }
+    QVERIFY(extracted > 0);
+}
+
+void HotPathBenchmarks::rationalFormatted_data() {
+    QTest::addColumn<int>("num");
+    QTest::addColumn<int>("den");
+    QTest::addColumn<int>("type");
+    QTest::newRow("aperture") << 28 << 10 << int(RationalType::Aperture);
+    QTest::newRow("focalLength") << 50 << 1 << int(RationalType::FocalLength);
+    QTest::newRow("shutterFraction") << 1 << 250 << int(RationalType::Shutter);
+    QTest::newRow("shutterSeconds") << 13 << 10 << int(RationalType::Shutter);
+    QTest::newRow("bias") << -2 << 3 << int(RationalType::Bias);
+}
+
+void HotPathBenchmarks::rationalFormatted() {
+    QFETCH(int, num);
+    QFETCH(int, den);
+    QFETCH(int, type);
+    const ExifValueRational value(num, den, RationalType(type));
+    QString text;
+    QBENCHMARK {
+        text = value.formatted();
+    }
+    QVERIFY(!text.isEmpty());
+}
+
+
+//----- Thumbnail scaling -----//
+
+void HotPathBenchmarks::scaleThumbnail_data() {
+    // Decoding rows include reading the JPEG, compare them with each other, not with the scale-only rows
+    QTest::addColumn<QString>("method");
+    QTest::newRow("scaled smooth") << QStringLiteral("smooth");
+    QTest::newRow("scaled fast") << QStringLiteral("fast");
+    QTest::newRow("decode + scaled smooth") << QStringLiteral("decodeSmooth");
+    QTest::newRow("decode at scaled size") << QStringLiteral("decodeScaled");
+}
+
+void HotPathBenchmarks::scaleThumbnail() {
+    QFETCH(QString, method);
+
+    // Shorter side to 200px like ThumbnailWorker
+    const int targetShort = 200;
+    const QSize size = m_largeImage.width() < m_largeImage.height()
+        ? QSize(targetShort, targetShort * m_largeImage.height() / m_largeImage.width())
+        : QSize(targetShort * m_largeImage.width() / m_largeImage.height(), targetShort);
+
+    QImage thumbnail;
+    QBENCHMARK {
+        if (method == QLatin1String("smooth")) thumbnail = m_largeImage.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        else if (method == QLatin1String("fast")) thumbnail = m_largeImage.scaled(size, Qt::KeepAspectRatio, Qt::FastTransformation);
+        else {
+            QImageReader reader(m_largePhoto);
+            reader.setAutoTransform(true);
+            if (method == QLatin1String("decodeScaled")) reader.setScaledSize(size);
+            thumbnail = reader.read();
+            if (method == QLatin1String("decodeSmooth")) thumbnail = thumbnail.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    QCOMPARE(thumbnail.size(), size);
+}
+
+
+//----- DirectoryModel -----//
+
+void HotPathBenchmarks::addDirectories_data() {
+    QTest::addColumn<int>("fanout");
+    QTest::addColumn<bool>("tree");
+    QTest::newRow("addDirectory 1k") << 10 << false;
+    QTest::newRow("addDirectory 10k") << 22 << false;
+    QTest::newRow("setTree 1k") << 10 << true;
+    QTest::newRow("setTree 10k") << 22 << true;
+}
+
+void HotPathBenchmarks::addDirectories() {
+    QFETCH(int, fanout);
+    QFETCH(bool, tree);
+
+    // Three levels below the root, parents before children like the scan reports them
+    const QString root = QStringLiteral("/bench");
+    QVector<WalkedDirectory> walked;
+    QStringList paths;
+    std::function<void(const QString &, int)> build = [&](const QString &path, int depth) {
+        WalkedDirectory directory;
+        directory.path = path;
+        if (depth < 3) {
+            for (int i = 0; i < fanout; ++i)
+                directory.directories << path + QStringLiteral("/album_%1").arg(i);
+        }
+        walked.append(directory);
+        for (const QString &child : directory.directories) {
+            paths << child;
+            build(child, depth + 1);
+        }
+    };
+    build(root, 0);
+
+    DirectoryModel model(m_settings.get());
+    QBENCHMARK {
+        model.clear();
+        model.setRootPath(root);
+        if (tree) {
+            DirectoryTree built;
+            for (const WalkedDirectory &directory : walked)
+                built.add(directory);
+            model.setTree(std::move(built));
+        }
+        else {
+            for (const QString &path : paths)
+                model.addDirectory(path);
+        }
+    }
+}
+
+
+//----- PhotoModel -----//
+
+void HotPathBenchmarks::addPhotos_data() {
+    QTest::addColumn<int>("batchSize");
+    QTest::newRow("batches of 100") << 100;
+    QTest::newRow("batches of 2000") << 2000;
+    QTest::newRow("one batch") << AddedPhotos;
+}
+
+void HotPathBenchmarks::addPhotos() {
+    QFETCH(int, batchSize);
+
+    const QVector<PhotoFile> photos = SyntheticLibrary::photoFiles(QStringLiteral("/bench"), AddedPhotos);
+    QVector<QVector<PhotoFile>> batches;
+    for (int first = 0; first < photos.size(); first += batchSize)
+        batches.append(photos.mid(first, batchSize));
+
+    // Includes clearing the previous iteration's rows, which is small next to the insertions
+    PhotoModel model(m_settings.get());
+    QBENCHMARK {
+        model.clear();
+        for (const QVector<PhotoFile> &batch : batches)
+            model.addPhotos(batch);
+    }
+    QCOMPARE(model.rowCount(), AddedPhotos);
+}
+
+// Measured rather than estimated: resident memory grown by building the rows, reported per photo.
+// Run the rows separately (rowMemory:legacy, rowMemory:store), memory freed earlier is reused otherwise.
+void HotPathBenchmarks::rowMemory_data() {
+    QTest::addColumn<bool>("legacy");
+    QTest::newRow("legacy") << true;
+    QTest::newRow("store") << false;
+}
+
+void HotPathBenchmarks::rowMemory() {
+    QFETCH(bool, legacy);
+
+    const QVector<PhotoFile> photos = SyntheticLibrary::photoFiles(QStringLiteral("/home/user/Pictures/library"), MemoryRows);
+    const qint64 before = BenchSupport::residentBytes();
+    QVERIFY(before > 0);
+
+    qint64 counted = -1;
+    QVector<LegacyPhotoItem> items;
+    QHash<QString, int> indexMap;
+    PhotoStore store;
+    if (legacy) {
+        // Paths were separate strings from the scanner, deep copies keep them from sharing the fixture's
+        for (const PhotoFile &photo : photos) {
+            LegacyPhotoItem item;
+            item.filePath = QString(photo.filePath.constData(), photo.filePath.size());
+            item.size = photo.size;
+            item.modified = photo.modified;
+            item.created = photo.created;
+            items.append(item);
+            indexMap.insert(item.filePath, items.size() - 1);
+        }
+    }
+    else {
+        for (const PhotoFile &photo : photos)
+            store.append(photo);
+        counted = store.memoryBytes(); // what memoryMetrics() reports
+    }
+
+    const qint64 grown = BenchSupport::residentBytes() - before;
+    qInfo().nospace() << (legacy ? "legacy" : "store") << ": " << grown / MemoryRows << " B resident per photo"
+                      << (counted >= 0 ? QStringLiteral(", %1 B counted by memoryMetrics()").arg(counted / MemoryRows) : QString());
+    QTest::setBenchmarkResult(qreal(grown) / MemoryRows, QTest::BytesAllocated);
+    QCOMPARE(legacy ? int(items.size()) : store.size(), MemoryRows);
+}
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setOrganizationName("vorks");
+    QGuiApplication::setApplicationName("lysa-microbench");
+
+    HotPathBenchmarks benchmarks;
+    return QTest::qExec(&benchmarks, argc, argv);
+}
+
+#include "microbench.moc"
@@ -0,0 +1,288 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Replays gallery scroll traces against the thumbnail pipeline and reports how the visible range kept up:
+// frame busy time at 60 Hz, time until visible thumbnails arrive, decodes that were never seen and peak memory.
+// Traces are recorded from the application with --record-scroll, or synthesised for a few typical patterns.
+// Usage: lysa-scrollbench [--trace FILE]... [--photos N] [--items-per-row N] [--visible-rows N] [--budget MB]
+//                         [--library DIR] [--output FILE] [--timeout SECONDS]
+
+#include "benchsupport.h"
+#include "syntheticlibrary.h"
+#include "photocontroller.h"
+#include "metrics.h"
+#include "scrolltrace.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr qint64 FrameNsecs = 1000000000 / 60;
+
+struct NamedTrace {
+    QString name;
+    ScrollTrace trace;
+};
+
+//----- Synthetic traces -----//
+
+// Scrolls the viewport row by row, one step every stepMsecs
+void scrollRows(ScrollTrace &trace, qint64 &msecs, int fromRow, int toRow, int stepMsecs, int itemsPerRow, int visibleRows, int photos) {
+    const int step = fromRow <= toRow ? 1 : -1;
+    for (int row = fromRow;; row += step) {
+        const int first = row * itemsPerRow;
+        const int last = std::min(first + visibleRows * itemsPerRow, photos) - 1;
+        if (first > last) break;
+        trace.events.append({ msecs, first, last, itemsPerRow, step });
+        msecs += stepMsecs;
+        if (row == toRow) break;
+    }
+}
+
+QVector<NamedTrace> syntheticTraces(int photos, int itemsPerRow, int visibleRows) {
+    const int rows = (photos + itemsPerRow - 1) / itemsPerRow;
+    const int lastRow = std::max(rows - visibleRows, 0);
+    QVector<NamedTrace> traces;
+
+    // Reading along at about two rows a second
+    NamedTrace slow { QStringLiteral("slow-browse"), {} };
+    qint64 msecs = 0;
+    scrollRows(slow.trace, msecs, 0, std::min(lastRow, 60), 500, itemsPerRow, visibleRows, photos);
+    traces.append(slow);
+
+    // Flicks through the album and back, a row per frame
+    NamedTrace flick { QStringLiteral("fast-flick"), {} };
+    msecs = 0;
+    scrollRows(flick.trace, msecs, 0, lastRow, 16, itemsPerRow, visibleRows, photos);
+    msecs += 1000;
+    scrollRows(flick.trace, msecs, lastRow, 0, 16, itemsPerRow, visibleRows, photos);
+    traces.append(flick);
+
+    // Dragging the scrollbar to the end, then settling
+    NamedTrace jump { QStringLiteral("jump-to-end"), {} };
+    const int visibleCount = std::min(visibleRows * itemsPerRow, photos);
+    jump.trace.events.append({ 0, 0, visibleCount - 1, itemsPerRow, 0 });
+    jump.trace.events.append({ 1000, photos - visibleCount, photos - 1, itemsPerRow, -1 });
+    jump.trace.events.append({ 3000, photos - visibleCount, photos - 1, itemsPerRow, 0 });
+    traces.append(jump);
+
+    // Zooming out and back in at the top, more and fewer items per row
+    NamedTrace zoom { QStringLiteral("zoom"), {} };
+    msecs = 0;
+    for (int perRow : { itemsPerRow, itemsPerRow * 2, itemsPerRow * 4, itemsPerRow * 2, itemsPerRow }) {
+        const int visible = std::min(visibleRows * perRow * perRow / itemsPerRow, photos); // smaller cells, more rows
+        zoom.trace.events.append({ msecs, 0, visible - 1, perRow, 0 });
+        msecs += 750;
+    }
+    traces.append(zoom);
+
+    return traces;
+}
+
+//----- Replay -----//
+
+qint64 percentile(std::vector<qint64> values, double fraction) {
+    if (values.empty()) return 0;
+    const size_t index = std::min(values.size() - 1, size_t(fraction * double(values.size())));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+QJsonObject msecsSummary(const std::vector<qint64> &nanoseconds) {
+    return {
+        { "count", int(nanoseconds.size()) },
+        { "p50", percentile(nanoseconds, 0.5) / 1e6 },
+        { "p95", percentile(nanoseconds, 0.95) / 1e6 },
+        { "max", nanoseconds.empty() ? 0.0 : *std::max_element(nanoseconds.begin(), nanoseconds.end()) / 1e6 }
+    };
+}
+
+QJsonObject replay(const ScrollTrace &trace, PhotoModel *model, GalleryModel *gallery, qint64 timeoutMsecs, bool &failed) {
+    const int photos = model->rowCount();
+    std::vector<qint64> visibleSince(photos, -1); // first time a row was requested as visible, ns into the replay
+    std::vector<qint64> arrivedAt(photos, -1);    // first time its thumbnail was set afterwards
+    std::vector<qint64> timeToVisible;
+
+    QElapsedTimer clock;
+    const auto onThumbnail = [&](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+        if (!roles.isEmpty() && !roles.contains(PhotoModel::ThumbPathRole)) return;
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            if (row < 0 || row >= photos || visibleSince[row] < 0 || arrivedAt[row] >= 0) continue;
+            if (model->thumbnailFile(row).isEmpty()) continue;
+            arrivedAt[row] = clock.nsecsElapsed();
+            timeToVisible.push_back(arrivedAt[row] - visibleSince[row]);
+        }
+    };
+    const QMetaObject::Connection connection = QObject::connect(model, &PhotoModel::dataChanged, model, onThumbnail);
+
+    const qint64 thumbnailsBefore = Metrics::counter(Metrics::ThumbnailsGenerated);
+    std::vector<qint64> frames;
+    int slowFrames = 0;
+    qint64 peakThumbnailBytes = 0;
+    int next = 0;
+
+    // One frame every 16.7 ms: apply the requests that are due, then let queued results land
+    clock.start();
+    while (next < trace.events.size()) {
+        const qint64 frameStart = clock.nsecsElapsed();
+        while (next < trace.events.size() && trace.events[next].msecs * 1000000 <= frameStart) {
+            const ScrollEvent &event = trace.events[next++];
+            for (int row = std::max(event.firstIndex, 0); row <= std::min(event.lastIndex, gallery->rowCount() - 1); ++row) {
+                const int sourceRow = gallery->mapToSource(row);
+                if (sourceRow < 0 || visibleSince[sourceRow] >= 0) continue;
+                visibleSince[sourceRow] = frameStart;
+                if (!model->thumbnailFile(sourceRow).isEmpty()) {
+                    arrivedAt[sourceRow] = frameStart;
+                    timeToVisible.push_back(0);
+                }
+            }
+            gallery->loadThumbnails(event.firstIndex, event.lastIndex, event.itemsPerRow, event.preloadDirection);
+        }
+        QCoreApplication::processEvents();
+
+        const qint64 busy = clock.nsecsElapsed() - frameStart;
+        frames.push_back(busy);
+        if (busy > FrameNsecs) ++slowFrames;
+        peakThumbnailBytes = std::max(peakThumbnailBytes, model->thumbnailMetrics().value("residentBytes").toLongLong());
+        if (busy < FrameNsecs) QThread::usleep((FrameNsecs - busy) / 1000);
+    }
+
+    // Let the decodes still in flight finish, so the wasted ones are complete. Rows that were evicted
+    // before their thumbnail arrived are never requested again and count as visible without thumbnail
+    failed |= !BenchSupport::waitFor([]() { return Metrics::idle(Metrics::ThumbnailPool); }, timeoutMsecs);
+    QCoreApplication::processEvents();
+    QObject::disconnect(connection);
+
+    int unseen = 0;
+    for (int row = 0; row < photos; ++row)
+        if (visibleSince[row] >= 0 && arrivedAt[row] < 0) ++unseen;
+    const qint64 decoded = Metrics::counter(Metrics::ThumbnailsGenerated) - thumbnailsBefore;
+    const qint64 useful = std::count_if(arrivedAt.begin(), arrivedAt.end(), [](qint64 at) { return at >= 0; });
+
+    return {
+        { "events", int(trace.events.size()) },
+        { "seconds", clock.nsecsElapsed() / 1e9 },
+        { "frameBusyMsecs", msecsSummary(frames) },
+        { "framesOverBudget", slowFrames },
+        { "timeToVisibleMsecs", msecsSummary(timeToVisible) },
+        { "visibleWithoutThumbnail", unseen },
+        { "decodes", decoded },
+        { "wastedDecodes", std::max<qint64>(decoded - useful, 0) },
+        { "peakThumbnailBytes", peakThumbnailBytes }
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setOrganizationName("vorks");
+    QGuiApplication::setApplicationName("lysa-scrollbench"); // caches apart from the application and lysa-bench
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"trace", "Replay a trace recorded with --record-scroll instead of the synthetic ones.", "file"});
+    parser.addOption({"photos", "Number of photos.", "n", "2000"});
+    parser.addOption({"items-per-row", "Thumbnails per row of the synthetic traces.", "n", "6"});
+    parser.addOption({"visible-rows", "Rows on screen of the synthetic traces.", "n", "5"});
+    parser.addOption({"budget", "Thumbnail memory budget.", "MB", "64"});
+    parser.addOption({"library", "Generate into DIR, or reuse it if it already has photos.", "dir"});
+    parser.addOption({"output", "Write the JSON report to FILE instead of stdout.", "file"});
+    parser.addOption({"timeout", "Give up on a phase after this many seconds.", "seconds", "600"});
+    parser.process(app);
+
+    SyntheticLibraryOptions options;
+    options.photos = parser.value("photos").toInt();
+    const qint64 timeoutMsecs = parser.value("timeout").toLongLong() * 1000;
+
+    QTextStream err(stderr);
+    QTemporaryDir temp;
+    QString root = parser.value("library");
+    if (root.isEmpty()) root = temp.path() + QStringLiteral("/library");
+
+    if (!QDir(root).exists() || QDir(root).isEmpty()) {
+        err << "Generating " << options.photos << " photos in " << root << "\n";
+        err.flush();
+        SyntheticLibrary::generate(root, options);
+    }
+
+    QVector<NamedTrace> traces;
+    for (const QString &path : parser.values("trace")) {
+        NamedTrace named { QFileInfo(path).completeBaseName(), {} };
+        if (!named.trace.load(path)) {
+            err << "Could not read trace " << path << "\n";
+            return 1;
+        }
+        traces.append(named);
+    }
+
+    AppSettings settings(BenchSupport::seedSettings(temp.path(), parser.value("budget")));
+
+    QJsonObject report;
+    QJsonObject results;
+    bool failed = false;
+    int photos = 0;
+    bool synthetic = traces.isEmpty();
+
+    // A fresh controller per trace, so no trace starts with the thumbnails of the previous one
+    for (int index = 0; synthetic || index < traces.size(); ++index) {
+        BenchSupport::clearCaches();
+        PhotoController controller(&settings);
+        PhotoModel *model = controller.photoModel();
+
+        const Metrics::Histogram exifBefore = Metrics::histogram(Metrics::ExifRead);
+        failed |= !BenchSupport::scan(controller, root, timeoutMsecs);
+        photos = model->rowCount();
+        failed |= !BenchSupport::waitForMetadata(exifBefore, photos, timeoutMsecs);
+
+        // The synthetic traces depend on the album size, which is known after the first scan
+        if (synthetic) {
+            traces = syntheticTraces(photos, std::max(parser.value("items-per-row").toInt(), 1), std::max(parser.value("visible-rows").toInt(), 1));
+            synthetic = false;
+        }
+        if (index >= traces.size()) break;
+
+        err << "Replaying " << traces[index].name << "\n";
+        err.flush();
+        results.insert(traces[index].name, replay(traces[index].trace, model, controller.galleryModel(), timeoutMsecs, failed));
+    }
+    BenchSupport::clearCaches();
+
+    report.insert("library", root);
+    report.insert("photos", photos);
+    report.insert("budgetMegabytes", parser.value("budget").toInt());
+    report.insert("traces", results);
+    report.insert("peakRssBytes", BenchSupport::peakResidentBytes());
+    report.insert("completed", !failed);
+
+    if (!BenchSupport::writeReport(report, parser.value("output"))) return 1;
+
+    if (failed) err << "A phase timed out, its numbers are incomplete\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticlibrary.h"
+#include <QColor>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <exiv2/exiv2.hpp>
+#include <iterator>
+#include <random>
+
+namespace {
+
+const char *cameras[] = { "EOS R6", "X-T4", "Alpha 7 IV", "Z 6II", "OM-1", "iPhone 13 Pro" };
+const char *makers[] = { "Canon", "FUJIFILM", "SONY", "NIKON CORPORATION", "OM Digital Solutions", "Apple" };
+const char *lenses[] = { "RF24-105mm F4 L IS USM", "XF35mmF1.4 R", "FE 24-70mm F2.8 GM II", "NIKKOR Z 50mm f/1.8 S", "M.Zuiko 12-40mm F2.8 PRO", "" };
+const uint16_t isoValues[] = { 100, 200, 400, 800, 1600, 3200, 6400 };
+const uint32_t apertures[] = { 14, 18, 28, 40, 56, 80, 110 };       // tenths
+const uint32_t focalLengths[] = { 14, 24, 35, 50, 85, 105, 200 };
+const uint32_t shutterDenominators[] = { 30, 60, 125, 250, 500, 1000, 4000 };
+
+template<typename T, size_t N>
+const T& pick(std::mt19937 &rng, const T (&values)[N]) {
+    return values[rng() % N]; // raw engine output, distributions differ between standard libraries
+}
+
+void addDirectories(const QString &path, int depth, int fanout, QStringList &directories) {
+    QDir().mkpath(path);
+    directories << path;
+    if (depth == 0) return;
+    for (int i = 0; i < fanout; ++i)
+        addDirectories(path + QStringLiteral("/album_%1").arg(i), depth - 1, fanout, directories);
+}
+
+QImage render(std::mt19937 &rng, int width, int height) {
+    QImage image(width, height, QImage::Format_RGB32);
+    QPainter painter(&image);
+
+    // A gradient with shapes on top compresses roughly like a photo, unlike a flat color
+    QLinearGradient gradient(0, 0, width, height);
+    gradient.setColorAt(0, QColor::fromRgb(QRgb(rng())));
+    gradient.setColorAt(1, QColor::fromRgb(QRgb(rng())));
+    painter.fillRect(image.rect(), gradient);
+
+    painter.setPen(Qt::NoPen);
+    painter.setRenderHint(QPainter::Antialiasing);
+    for (int i = 0; i < 24; ++i) {
+        QColor color = QColor::fromRgb(QRgb(rng()));
+        color.setAlpha(int(rng() % 200) + 40);
+        painter.setBrush(color);
+        const int w = int(rng() % uint32_t(width / 2)) + 8;
+        const int h = int(rng() % uint32_t(height / 2)) + 8;
+        painter.drawEllipse(int(rng() % uint32_t(width)) - w / 2, int(rng() % uint32_t(height)) - h / 2, w, h);
+    }
+    painter.end();
+    return image;
+}
+
+QDateTime takenAt(std::mt19937 &rng) {
+    return QDateTime(QDate(2015, 1, 1), QTime(0, 0)).addSecs(qint64(rng() % (10u * 365u * 24u * 3600u)));
+}
+
+void writeExif(std::mt19937 &rng, const QString &filePath) {
+    const size_t camera = rng() % std::size(cameras);
+    const QDateTime taken = takenAt(rng);
+
+    Exiv2::Image::UniquePtr image = Exiv2::ImageFactory::open(filePath.toStdString());
+    image->readMetadata();
+    Exiv2::ExifData &exif = image->exifData();
+    exif["Exif.Image.Make"] = makers[camera];
+    exif["Exif.Image.Model"] = cameras[camera];
+    if (*lenses[camera]) exif["Exif.Photo.LensModel"] = lenses[camera];
+    exif["Exif.Image.Software"] = "lysa-bench";
+    exif["Exif.Photo.DateTimeOriginal"] = taken.toString("yyyy:MM:dd HH:mm:ss").toStdString();
+    exif["Exif.Photo.ISOSpeedRatings"] = pick(rng, isoValues);
+    exif["Exif.Photo.FNumber"] = Exiv2::URational(pick(rng, apertures), 10);
+    exif["Exif.Photo.FocalLength"] = Exiv2::URational(pick(rng, focalLengths), 1);
+    exif["Exif.Photo.ExposureTime"] = Exiv2::URational(1, pick(rng, shutterDenominators));
+    exif["Exif.Photo.Flash"] = uint16_t(rng() % 2);
+    image->writeMetadata();
+}
+
+} // namespace
+
+SyntheticLibrary SyntheticLibrary::generate(const QString &root, const SyntheticLibraryOptions &options) {
+    SyntheticLibrary library;
+    library.root = QDir::cleanPath(root);
+    addDirectories(library.root, options.depth, options.fanout, library.directories);
+
+    std::mt19937 rng(options.seed);
+    for (int i = 0; i < options.photos; ++i) {
+        const bool png = int(rng() % 100) < options.pngPercent;
+        const QString &directory = library.directories[i % library.directories.size()];
+        const QString filePath = directory + QStringLiteral("/IMG_%1.%2").arg(i, 5, 10, QChar('0')).arg(png ? "png" : "jpg");
+
+        const QImage image = render(rng, options.width, options.height);
+        if (!image.save(filePath, png ? "PNG" : "JPG", png ? -1 : 90)) continue;
+        try {
+            writeExif(rng, filePath);
+        }
+        catch (const Exiv2::Error &) {
+            // Still a valid photo, just without metadata
+        }
+
+        library.files << filePath;
+        library.bytes += QFileInfo(filePath).size();
+    }
+    return library;
+}
+
+QVector<PhotoFile> SyntheticLibrary::photoFiles(const QString &root, int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    QVector<PhotoFile> photos;
+    photos.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        PhotoFile photo;
+        photo.filePath = root + QStringLiteral("/album_%1/album_%2/IMG_%3.jpg").arg(i % 7).arg(i % 5).arg(i, 6, 10, QChar('0'));
+        photo.size = qint64(rng() % (12u * 1024u * 1024u)) + 200 * 1024;
+        photo.modified = takenAt(rng).toMSecsSinceEpoch();
+        photo.created = photo.modified;
+        photos.append(photo);
+    }
+    return photos;
+}
+
+QHash<QString, ExifData> SyntheticLibrary::metadata(const QVector<PhotoFile> &photos, uint32_t seed) {
+    std::mt19937 rng(seed);
+    QHash<QString, ExifData> metadata;
+    metadata.reserve(photos.size());
+    for (const PhotoFile &photo : photos) {
+        const size_t camera = rng() % std::size(cameras);
+        ExifData data {};
+        data.maker = makers[camera];
+        data.cameraModel = cameras[camera];
+        data.lensModel = lenses[camera];
+        data.dateTaken = takenAt(rng);
+        data.iso = pick(rng, isoValues);
+        data.aperture = ExifValueRational(int(pick(rng, apertures)), 10, RationalType::Aperture);
+        data.focalLength = ExifValueRational(int(pick(rng, focalLengths)), 1, RationalType::FocalLength);
+        data.exposureTime = ExifValueRational(1, int(pick(rng, shutterDenominators)), RationalType::Shutter);
+        data.exposureBias = ExifValueRational(0, 1, RationalType::Bias);
+        metadata.insert(photo.filePath, data);
+    }
+    return metadata;
+}
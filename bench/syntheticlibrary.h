@@ -0,0 +1,50 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "structs.h"
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+
+// Reproducible photo library for benchmarks: the same options always produce the same tree, pixels and EXIF.
+// Photos are spread evenly over a tree of depth levels with fanout subdirectories each.
+struct SyntheticLibraryOptions {
+    int photos = 500;
+    int width = 1024;
+    int height = 768;
+    int depth = 3;
+    int fanout = 3;
+    int pngPercent = 10; // the rest are JPEGs
+    uint32_t seed = 1;
+};
+
+struct SyntheticLibrary {
+    QString root;
+    QStringList directories; // root first
+    QStringList files;
+    qint64 bytes = 0;
+
+    static SyntheticLibrary generate(const QString &root, const SyntheticLibraryOptions &options);
+
+    // In-memory rows and metadata with the same distributions, for kernels that do not touch files
+    static QVector<PhotoFile> photoFiles(const QString &root, int count, uint32_t seed = 1);
+    static QHash<QString, ExifData> metadata(const QVector<PhotoFile> &photos, uint32_t seed = 1);
+};
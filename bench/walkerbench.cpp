@@ -0,0 +1,127 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Compares DirectoryWalker with a recursive QDirIterator on a synthetic deep tree (or an existing one).
+// Usage: lysa-walkerbench [--depth N] [--fanout N] [--files N] [--threads N] [--runs N] [--root DIR]
+
+#include "directorywalker.h"
+#include "taskscheduler.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace {
+
+void createTree(const QString &path, int depth, int fanout, int files) {
+    QDir().mkpath(path);
+    for (int i = 0; i < files; ++i) {
+        QFile file(path + QStringLiteral("/IMG_%1.jpg").arg(i, 4, 10, QChar('0')));
+        if (!file.open(QIODevice::WriteOnly)) return;
+    }
+    QFile notes(path + QStringLiteral("/notes.txt")); // not matched by the filters
+    if (!notes.open(QIODevice::WriteOnly)) return;
+
+    if (depth == 0) return;
+    for (int i = 0; i < fanout; ++i)
+        createTree(path + QStringLiteral("/dir%1").arg(i), depth - 1, fanout, files);
+}
+
+// Median of several runs, after one warm-up run
+double measure(int runs, const std::function<qsizetype()> &walk, qsizetype &found) {
+    found = walk();
+    std::vector<double> times;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        found = walk();
+        times.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"depth", "Depth of the synthetic tree.", "n", "6"});
+    parser.addOption({"fanout", "Subdirectories per directory.", "n", "4"});
+    parser.addOption({"files", "Photos per directory.", "n", "10"});
+    parser.addOption({"threads", "I/O lane workers, 0 for the default.", "n", "0"});
+    parser.addOption({"runs", "Measured runs per variant.", "n", "5"});
+    parser.addOption({"root", "Walk an existing directory instead of a synthetic tree.", "dir"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTemporaryDir temp;
+    QString root = parser.value("root");
+    if (root.isEmpty()) {
+        root = temp.path() + QStringLiteral("/tree");
+        createTree(root, parser.value("depth").toInt(), parser.value("fanout").toInt(), parser.value("files").toInt());
+    }
+
+    const int runs = std::max(1, parser.value("runs").toInt());
+    const QStringList filters = {"*.jpg", "*.jpeg", "*.png", "*.bmp"};
+    const QStringList suffixes = {"jpg", "jpeg", "png", "bmp"};
+
+    qsizetype iteratorFiles = 0;
+    const double iteratorMs = measure(runs, [&] {
+        qsizetype count = 0;
+        QDirIterator it(root, filters, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            ++count;
+        }
+        return count;
+    }, iteratorFiles);
+    out << "QDirIterator:          " << iteratorFiles << " files, " << iteratorMs << " ms\n";
+
+    const int threadCounts[] = { 1, parser.value("threads").toInt() };
+    for (int threads : threadCounts) {
+        TaskScheduler scheduler(1, threads); // the walker only uses the I/O lane
+        const DirectoryWalker walker(suffixes, TaskScheduler::Background, scheduler);
+        qsizetype walkerFiles = 0;
+        const double walkerMs = measure(runs, [&] {
+            qsizetype count = 0;
+            walker.walk(root, [&count](const WalkedDirectory &directory) {
+                count += directory.files.size();
+                return true;
+            });
+            return count;
+        }, walkerFiles);
+
+        const QString label = threads > 0 ? QStringLiteral("%1 I/O workers").arg(threads) : QStringLiteral("default I/O workers");
+        out << "DirectoryWalker (" << label << "): " << walkerFiles << " files, " << walkerMs << " ms, "
+            << "speedup " << (walkerMs > 0 ? iteratorMs / walkerMs : 0.0) << "x\n";
+        if (walkerFiles != iteratorFiles)
+            out << "  file count differs from QDirIterator\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Licensed under GNU GPL-3
+* Full license: see LICENSE.txt
+*/
+
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import "."
+
+// Live performance counters of performanceMetrics, shown while UI.showMetrics is set
+Rectangle {
+    id: overlay
+    visible: UI.showMetrics
+    z: 100
+    width: metricsText.implicitWidth + 20
+    height: metricsText.implicitHeight + 16
+    radius: 6
+    color: UI.backgroundLite
+    opacity: 0.9
+    border.color: UI.font
+    border.width: 1
+
+    readonly property var values: performanceMetrics.values
+
+    function formatBytes(bytes) {
+        if (bytes >= 1024 * 1024 * 1024) return (bytes / (1024 * 1024 * 1024)).toFixed(1) + " GB"
+        if (bytes >= 1024 * 1024) return (bytes / (1024 * 1024)).toFixed(1) + " MB"
+        if (bytes >= 1024) return (bytes / 1024).toFixed(1) + " KB"
+        return bytes + " B"
+    }
+
+    function latencyLine(label, latency) {
+        if (!latency) return label + ": –"
+        return `${label}: p50 ${latency.p50.toFixed(1)} / p90 ${latency.p90.toFixed(1)} / p99 ${latency.p99.toFixed(1)} ms`
+    }
+
+    function describe() {
+        if (!values || values.pools === undefined) return "Collecting metrics..."
+
+        let lines = []
+        for (let pool of values.pools)
+            lines.push(`${pool.name}: ${pool.queued} queued, ${pool.active} running`)
+        for (let lane of values.lanes)
+            lines.push(`${lane.name} lane: ${lane.busy}/${lane.threads} busy`)
+        lines.push("")
+        lines.push(`${values.thumbnailsPerSecond.toFixed(1)} thumbnails/s`)
+        lines.push(latencyLine("Thumbnail decode", values.latencies.thumbnailDecode))
+        lines.push(latencyLine("EXIF read", values.latencies.exifRead))
+        lines.push(latencyLine("Photo decode", values.latencies.photoDecode))
+        lines.push("")
+        lines.push(`Thumbnail hit rate: ${(values.thumbnailHitRate * 100).toFixed(1)} %`)
+        lines.push(`Thumbnails: ${values.thumbnailCount}, ${formatBytes(values.thumbnailBytes)} of ${formatBytes(values.thumbnailBudgetBytes)}`)
+        lines.push(`Photo views: ${values.providerCount}, ${formatBytes(values.providerBytes)}`)
+        lines.push(`Photo rows: ${formatBytes(values.photoBytes)}`)
+        lines.push(`GUI thread in models: ${(values.guiModelLoad * 100).toFixed(1)} %`)
+        return lines.join("\n")
+    }
+
+    Text {
+        id: metricsText
+        anchors.centerIn: parent
+        color: UI.font
+        font.family: "monospace"
+        font.pixelSize: 11
+        text: overlay.describe()
+    }
+}
@@ -34,6 +34,9 @@ QtObject {
 
     property int mainWindowWidth
 
+    // Performance overlay, not persisted, sampling only runs while it is shown
+    property bool showMetrics: false
+
     //----- settingsModel initialization -----//
     property var settingsModel: null
     onSettingsModelChanged: {
@@ -147,6 +147,11 @@ ApplicationWindow {
 
             property var chainToActive: []
             function calcChainToActive() { chainToActive = directoryModel.parentPathChain(directoryModel.activePath) }
+            function formatBytes(bytes) {
+                if (bytes >= 1073741824) return (bytes / 1073741824).toFixed(1) + " GB"
+                if (bytes >= 1048576) return (bytes / 1048576).toFixed(1) + " MB"
+                return Math.round(bytes / 1024) + " KB"
+            }
 
             Component.onCompleted: calcChainToActive()
             Connections {
@@ -160,6 +165,10 @@ ApplicationWindow {
                 id: delegateItem
                 required property string name
                 required property string path
+                required property int photoCount
+                required property double totalBytes
+                required property var firstDate
+                required property var lastDate
                 required property bool hasChildren
                 required property bool expanded
                 required property int depth
@@ -187,6 +196,30 @@ ApplicationWindow {
                     radius: 4
                 }
 
+                // Album stats from the library index, read when hovered
+                HoverHandler { id: hover }
+                ToolTip {
+                    id: statsTip
+                    delay: 1000
+                    timeout: 5000
+                    visible: hover.hovered && delegateItem.photoCount > 0
+                    text: delegateItem.photoCount + " photos \u00B7 " + directoryTree.formatBytes(delegateItem.totalBytes)
+                          + "\n" + Qt.formatDate(delegateItem.firstDate, "yyyy-MM-dd") + " \u2013 " + Qt.formatDate(delegateItem.lastDate, "yyyy-MM-dd")
+
+                    background: Rectangle {
+                        color: UI.backgroundLite
+                        radius: 6
+                        border.color: UI.font
+                        border.width: 1
+                    }
+
+                    contentItem: Text {
+                        text: statsTip.text
+                        color: UI.font
+                        font.pixelSize: 12
+                    }
+                }
+
                 Row {
                     id: row
                     anchors.fill: parent
@@ -227,6 +260,14 @@ ApplicationWindow {
                             }
                         }
                     }
+
+                    Text {
+                        text: delegateItem.photoCount > 0 ? delegateItem.photoCount : ""
+                        verticalAlignment: Text.AlignVCenter
+                        anchors.verticalCenter: parent.verticalCenter
+                        color: UI.font
+                        opacity: 0.5
+                    }
                 }
             }
         }
@@ -320,6 +361,80 @@ ApplicationWindow {
         Component.onCompleted: requestThumbnails()
     }
 
+    Item {
+        id: timelineScrubber
+        anchors.top: photoGrid.top
+        anchors.bottom: photoGrid.bottom
+        anchors.right: photoGrid.right
+        width: 18
+        visible: months.length > 1
+
+        property var months: galleryModel.timeline
+        property var preview: null
+
+        function bucketAt(y) {
+            if (photoGrid.count <= 0) return null
+            let row = Math.floor(Math.max(0, Math.min(1, y / height)) * (photoGrid.count - 1))
+            let bucket = galleryModel.timelineBucketAt(row)
+            return bucket.firstRow !== undefined ? bucket : null
+        }
+
+        function label(bucket) {
+            return Qt.locale().standaloneMonthName(bucket.month - 1, Locale.LongFormat) + " " + bucket.year
+        }
+
+        // Year ticks at the position of their first photo
+        Repeater {
+            model: timelineScrubber.months
+            delegate: Rectangle {
+                required property var modelData
+                required property int index
+                visible: index === 0 || modelData.year !== timelineScrubber.months[index - 1].year
+                x: 4
+                y: modelData.firstRow / Math.max(1, photoGrid.count) * timelineScrubber.height
+                width: timelineScrubber.width - 8
+                height: 2
+                radius: 1
+                color: UI.font
+                opacity: 0.4
+            }
+        }
+
+        Rectangle {
+            id: scrubberBubble
+            visible: timelineScrubber.preview !== null
+            anchors.right: parent.left
+            anchors.rightMargin: 6
+            y: Math.max(0, Math.min(timelineScrubber.height - height, scrubArea.mouseY - height / 2))
+            width: bubbleText.implicitWidth + 16
+            height: bubbleText.implicitHeight + 8
+            radius: 4
+            color: UI.backgroundLite
+
+            Text {
+                id: bubbleText
+                anchors.centerIn: parent
+                color: UI.font
+                text: timelineScrubber.preview ? timelineScrubber.label(timelineScrubber.preview) : ""
+            }
+        }
+
+        // Only previews while dragging, the grid jumps once on release so no thumbnails are requested in between
+        MouseArea {
+            id: scrubArea
+            anchors.fill: parent
+            preventStealing: true
+            cursorShape: Qt.PointingHandCursor
+            onPressed: (mouse) => timelineScrubber.preview = timelineScrubber.bucketAt(mouse.y)
+            onPositionChanged: (mouse) => { if (pressed) timelineScrubber.preview = timelineScrubber.bucketAt(mouse.y) }
+            onReleased: {
+                if (timelineScrubber.preview) photoGrid.positionViewAtIndex(timelineScrubber.preview.firstRow, GridView.Beginning)
+                timelineScrubber.preview = null
+            }
+            onCanceled: timelineScrubber.preview = null
+        }
+    }
+
     Rectangle {
         id: galleryLoadingScreen
         color: UI.background
@@ -348,6 +463,28 @@ ApplicationWindow {
         }
     }
 
+    MetricsOverlay {
+        anchors.top: photoGrid.top
+        anchors.left: photoGrid.left
+        anchors.margins: 10
+    }
+
+    // F12 toggles the performance overlay, Ctrl+F12 writes the metrics to the log
+    Shortcut {
+        sequence: "F12"
+        onActivated: UI.showMetrics = !UI.showMetrics
+    }
+    Shortcut {
+        sequence: "Ctrl+F12"
+        onActivated: performanceMetrics.dumpToLog()
+    }
+
+    Binding {
+        target: performanceMetrics
+        property: "active"
+        value: UI.showMetrics
+    }
+
     Connections {
         target: galleryModel
 
@@ -53,6 +53,14 @@ ApplicationWindow {
         sequence: "Left"
         onActivated: window.switchPhoto(-1)
     }
+    Shortcut {
+        sequence: "F12"
+        onActivated: UI.showMetrics = !UI.showMetrics
+    }
+    Shortcut {
+        sequence: "Ctrl+F12"
+        onActivated: performanceMetrics.dumpToLog()
+    }
 
     function switchPhoto(next) {
         if(next === 0) return;
@@ -126,6 +134,12 @@ ApplicationWindow {
         }
     }
 
+    MetricsOverlay {
+        anchors.top: toolBar.bottom
+        anchors.left: parent.left
+        anchors.margins: 10
+    }
+
     Rectangle {
         id: sideBar
         width: UI.showPhotoMetadata ? 300 : 0
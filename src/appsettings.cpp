@@ -20,9 +20,25 @@
 
 AppSettings::AppSettings(QObject *parent)
     : QAbstractListModel(parent), m_settings("vorks", "Lysa") {
-        loadFromSettings();
+        init();
     }
 
+AppSettings::AppSettings(const QString &filePath, QObject *parent)
+    : QAbstractListModel(parent), m_settings(filePath, QSettings::IniFormat) {
+        init();
+    }
+
+void AppSettings::init() {
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushDelayMsecs);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() { flushPending(false); });
+    loadFromSettings();
+}
+
+AppSettings::~AppSettings() {
+    flush();
+}
+
 
 //----- QAbstractListModel override -----//
 int AppSettings::rowCount(const QModelIndex &parent) const {
@@ -72,6 +88,7 @@ QHash<int, QByteArray> AppSettings::roleNames() const {
 void AppSettings::loadFromSettings() {
     beginResetModel();
     m_items.clear();
+    m_rows.clear();
 
     // Define all settings automatically
     m_items = {
@@ -79,8 +96,10 @@ void AppSettings::loadFromSettings() {
         {"theme", "Theme", "General", "ComboBox", m_settings.value("theme", "dark").toString(), {"dark", "light"}, true},
         {"autoHideToolbar", "Automatically hide Toolbar", "General", "Switch", m_settings.value("autoHideToolbar", false).toBool(), {}, true},
         {"rootFolder", "Root Folder", "Gallery", "FolderDialog", m_settings.value("rootFolder", "").toString(), {}, true},
-        {"gallerySortMode", "Sort by", "Gallery", "ComboBox", m_settings.value("gallerySortMode", "date").toString(), {"date", "size", "exposure", "camera", "iso", "focalLength"}, true},
+        {"gallerySortMode", "Sort by", "Gallery", "ComboBox", m_settings.value("gallerySortMode", "date").toString(), {"date", "name", "size", "exposure", "camera", "iso", "focalLength"}, true},
         {"gallerySortAscending", "Sort in ascending order", "Gallery", "Switch", m_settings.value("gallerySortAscending", true).toBool(), {}, true},
+        {"thumbnailMemoryBudget", "Thumbnail memory (MB)", "Gallery", "ComboBox", m_settings.value("thumbnailMemoryBudget", "256").toString(), {"64", "128", "256", "512", "1024"}, true},
+        {"thumbnailDiskCache", "Thumbnail disk cache (MB)", "Gallery", "ComboBox", m_settings.value("thumbnailDiskCache", "2048").toString(), {"512", "1024", "2048", "4096", "8192"}, true},
         {"photoBackground", "Fullscreen Background", "Photo View", "ComboBox", m_settings.value("photoBackground", "black").toString(), {"black", "standard"}},
 
         // About-Section
@@ -101,21 +120,26 @@ void AppSettings::loadFromSettings() {
         {"openedDirectory", "Opened Album", "Gallery", "FolderDialog", m_settings.value("openedDirectory", "").toString(), {}, false},
         {"galleryTargetWidth", "Targetted thumbnail width", "Gallery", "TextField", m_settings.value("galleryTargetWidth", 200).toInt(), {}, false},
         {"photoWindowMaximized", "Photo-Window Maximized", "Photo View", "Switch", m_settings.value("photoWindowMaximized", false).toBool(), {}, false},
-        {"showPhotoMetadata", "Metadata visible", "Photo View", "Switch", m_settings.value("showPhotoMetadata", false).toBool(), {}, false}
+        {"showPhotoMetadata", "Metadata visible", "Photo View", "Switch", m_settings.value("showPhotoMetadata", false).toBool(), {}, false},
+        {"traceFile", "Performance trace file", "General", "TextField", m_settings.value("traceFile", "").toString(), {}, false}
     };
+    for(int i = 0; i < m_items.size(); ++i)
+        m_rows.insert(m_items[i].id, i);
     endResetModel();
 }
 
 void AppSettings::setVisible(const QString &id, bool visible) {
-    for(int i = 0; i < m_items.size(); ++i) {
-        if(m_items[i].id != id) continue;
-        m_items[i].visible = visible;
-        emit dataChanged(index(i), index(i), {VisibleRole});
-        break;
-    }
+    const int i = m_rows.value(id, -1);
+    if(i < 0) return;
+    m_items[i].visible = visible;
+    emit dataChanged(index(i), index(i), {VisibleRole});
 }
 
 void AppSettings::reload() {
+    // Unsaved values would be read back as their stored predecessors
+    flush();
+    m_settings.sync();
+    m_written.clear();
     loadFromSettings();
 }
 
@@ -150,33 +174,61 @@ QVariantList AppSettings::getSections() const {
 
 //----- Runtime helpers -----//
 QVariant AppSettings::getValue(const QString &id) const {
-    for(const auto &item : m_items) {
-        if(item.id == id)
-            return item.value;
-    }
+    const int i = m_rows.value(id, -1);
+    if(i >= 0) return m_items[i].value;
 
     // Check QSettings if no active setting
-    if(m_settings.contains(id)) {
-        QVariant v = m_settings.value(id);
-        return v;
+    return storedValue(id, QVariant());
+}
+
+void AppSettings::setValue(const QString &id, const QVariant &value) {
+    const int i = m_rows.value(id, -1);
+    if(i >= 0) {
+        if(m_items[i].value == value) return;
+        m_items[i].value = value;
+        emit dataChanged(index(i), index(i), {ValueRole});
+        emit settingChanged(id, value);
     }
+    else if(storedValue(id, QVariant()) == value) return;
 
-    return {};
+    // Bursts like zooming or clicking through albums end up in one write
+    m_written.insert(id, value);
+    m_pending.insert(id, value);
+    if(!m_flushTimer.isActive()) m_flushTimer.start();
 }
 
-void AppSettings::setValue(const QString &id, const QVariant &value) {
-    qDebug() << "Setting" << id << "to" << value;
-    for(int i = 0; i < m_items.size(); ++i) {
-        if(m_items[i].id != id) continue;
-        if(m_items[i].value != value) {
-            m_items[i].value = value;
-            emit dataChanged(index(i), index(i), {ValueRole});
-            emit settingChanged(id, value);
+QVariant AppSettings::storedValue(const QString &id, const QVariant &fallback) const {
+    auto it = m_written.constFind(id);
+    if(it != m_written.cend()) return it.value();
+    return m_settings.value(id, fallback);
+}
+
+void AppSettings::flush() {
+    m_flushTimer.stop();
+    flushPending(true);
+}
+
+void AppSettings::flushPending(bool wait) {
+    // One store at a time, so an older batch never overwrites a newer one
+    if(m_flushTasks.outstanding() > 0) {
+        if(!wait) {
+            m_flushTimer.start();
+            return;
         }
-        break;
+        m_flushTasks.waitForDone();
     }
-
-    // Save to QSettings
-    m_settings.setValue(id, value);
-    m_settings.sync();
+    if(m_pending.isEmpty()) return;
+
+    const QVariantMap values = m_pending;
+    const QString fileName = m_settings.fileName();
+    const QSettings::Format format = m_settings.format();
+    m_pending.clear();
+    // Small, and waited for on the GUI thread at exit, so not behind the background scans
+    m_flushTasks.run(TaskScheduler::Visible, TaskScheduler::IoLane, [values, fileName, format]() {
+        QSettings settings(fileName, format); // the same store as m_settings, a registry path under native Windows settings
+        for(auto it = values.cbegin(); it != values.cend(); ++it)
+            settings.setValue(it.key(), it.value());
+        settings.sync();
+    });
+    if(wait) m_flushTasks.waitForDone();
 }
\ No newline at end of file
@@ -23,6 +23,9 @@
 #include <QAbstractListModel>
 #include <QVariantList>
 #include <QSortFilterProxyModel>
+#include <QHash>
+#include <QTimer>
+#include "taskscheduler.h"
 
 struct SettingItem {
     QString id;
@@ -47,6 +50,8 @@ public:
         VisibleRole
     };
     explicit AppSettings(QObject *parent = nullptr);
+    explicit AppSettings(const QString &filePath, QObject *parent = nullptr); // ini file instead of the user's settings, for tools and benchmarks
+    ~AppSettings();
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role) const override;
@@ -61,12 +66,26 @@ public:
 
     Q_INVOKABLE QVariant getValue(const QString &id) const;
     Q_INVOKABLE void setValue(const QString &id, const QVariant &value);
+    template<typename T> T value(const QString &id) const { return getValue(id).value<T>(); }
+
+    // Writes are coalesced and stored off the GUI thread, flush() stores them right away
+    void flush();
 
 signals:
     void settingChanged(const QString &id, const QVariant &value);
 
 private:
+    static constexpr int FlushDelayMsecs = 1000;
+
     QList<SettingItem> m_items;
-    QSettings m_settings;
+    QHash<QString, int> m_rows; // id -> index in m_items
+    QSettings m_settings;       // reads only, writes are stored by a separate instance off the GUI thread
+    QVariantMap m_written;      // values set this session, m_settings does not see them before reload()
+    QVariantMap m_pending;      // values not stored yet
+    QTimer m_flushTimer;
+    TaskGroup m_flushTasks { Metrics::SettingsPool };
+    void init();
     void loadFromSettings();
+    void flushPending(bool wait);
+    QVariant storedValue(const QString &id, const QVariant &fallback) const;
 };
@@ -0,0 +1,124 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "asynclogger.h"
+#include <chrono>
+#include <cstdlib>
+
+std::atomic<AsyncLogger *> AsyncLogger::s_instance {nullptr};
+std::atomic<int> AsyncLogger::s_producers {0};
+
+AsyncLogger::AsyncLogger(const QString &filePath, size_t capacity)
+    : m_file(filePath), m_queue(capacity)
+{
+    m_file.open(QIODevice::WriteOnly | QIODevice::Text);
+    m_clock.start();
+    m_started = QDateTime::currentDateTime();
+    m_writer = std::thread(&AsyncLogger::run, this);
+
+    s_instance.store(this);
+    m_previousHandler = qInstallMessageHandler(messageHandler);
+}
+
+AsyncLogger::~AsyncLogger() {
+    qInstallMessageHandler(m_previousHandler);
+    s_instance.store(nullptr);
+    while (s_producers.load() > 0)
+        std::this_thread::yield();
+
+    m_running = false;
+    m_wake.notify_one();
+    m_writer.join();
+    writeBatch(); // messages that raced with the shutdown
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    // Counted before the instance is loaded, so the destructor either sees the producer or the producer sees null
+    s_producers.fetch_add(1);
+    if (AsyncLogger *logger = s_instance.load()) logger->log(type, message);
+    s_producers.fetch_sub(1);
+}
+
+void AsyncLogger::log(QtMsgType type, const QString &message) {
+    if (!m_file.isOpen()) return;
+
+    if (!m_queue.push({ m_clock.elapsed(), type, message })) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    // The writer polls, it is only woken early when the queue fills up
+    if (m_queue.sizeApprox() > m_queue.capacity() / 2) m_wake.notify_one();
+
+    if (type == QtFatalMsg) {
+        flush();
+        abort();
+    }
+}
+
+void AsyncLogger::flush() {
+    const quint64 target = m_enqueued.load();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake.notify_one();
+    m_drained.wait_for(lock, std::chrono::seconds(2), [this, target] { return m_written.load() >= target || !m_running; });
+}
+
+void AsyncLogger::run() {
+    while (m_running) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(WriteIntervalMsecs));
+        }
+        writeBatch();
+        m_drained.notify_all();
+    }
+}
+
+bool AsyncLogger::writeBatch() {
+    QByteArray batch;
+    Entry entry;
+    quint64 taken = 0;
+    while (m_queue.pop(entry)) {
+        QString prefix;
+        switch (entry.type) {
+            case QtDebugMsg: prefix = "DEBUG"; break;
+            case QtInfoMsg: prefix = "INFO"; break;
+            case QtWarningMsg: prefix = "WARN"; break;
+            case QtCriticalMsg: prefix = "CRIT"; break;
+            case QtFatalMsg: prefix = "FATAL"; break;
+        }
+
+        // Wall clock from the monotonic offset, logging threads never format dates
+        batch += m_started.addMSecs(entry.msecs).toString("yyyy-MM-dd hh:mm:ss").toUtf8()
+              + " [" + prefix.toUtf8() + "] " + entry.message.toUtf8() + '\n';
+        ++taken;
+    }
+
+    const quint64 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+        batch += m_started.addMSecs(m_clock.elapsed()).toString("yyyy-MM-dd hh:mm:ss").toUtf8()
+              + " [WARN] " + QByteArray::number(dropped) + " log messages dropped, the queue was full\n";
+
+    if (!batch.isEmpty()) {
+        m_file.write(batch);
+        m_file.flush();
+    }
+    m_written.fetch_add(taken);
+    return taken > 0;
+}
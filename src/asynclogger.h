@@ -0,0 +1,133 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Bounded lock-free queue for many producers and one consumer (Vyukov's sequence-per-slot scheme).
+// push() fails instead of blocking when the queue is full.
+template<typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        m_mask = size - 1;
+        m_slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; ++i)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+    size_t sizeApprox() const { return m_enqueue.load(std::memory_order_relaxed) - m_dequeue.load(std::memory_order_relaxed); }
+
+    bool push(T &&value) {
+        size_t position = m_enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = m_slots[position & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0) {
+                if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) return false; // full
+            else position = m_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer thread only
+    bool pop(T &value) {
+        const size_t position = m_dequeue.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[position & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) return false;
+        value = std::move(slot.value);
+        slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+        m_dequeue.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_enqueue {0};
+    alignas(64) std::atomic<size_t> m_dequeue {0};
+};
+
+// Qt message handler that hands messages to a writer thread. Logging threads only take a monotonic
+// timestamp and enqueue, formatting and file writes happen in batches on the writer. When the queue is
+// full new messages are dropped and counted, the count is written once there is room again.
+class AsyncLogger {
+public:
+    explicit AsyncLogger(const QString &filePath, size_t capacity = 8192);
+    ~AsyncLogger();
+
+    void log(QtMsgType type, const QString &message);
+    void flush(); // blocks until everything enqueued so far is written
+
+private:
+    static constexpr int WriteIntervalMsecs = 100;
+
+    struct Entry {
+        qint64 msecs = 0; // since m_clock started
+        QtMsgType type = QtDebugMsg;
+        QString message;
+    };
+
+    // The handler can run on any thread while the logger is torn down, the destructor clears the
+    // instance and then waits until no handler is still inside log()
+    static std::atomic<AsyncLogger *> s_instance;
+    static std::atomic<int> s_producers;
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+    QDateTime m_started;
+    MpscRingBuffer<Entry> m_queue;
+    std::atomic<quint64> m_dropped {0};
+    std::atomic<quint64> m_written {0}; // entries taken by the writer, for flush()
+    std::atomic<quint64> m_enqueued {0};
+    std::atomic<bool> m_running {true};
+    QtMessageHandler m_previousHandler = nullptr;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+    std::thread m_writer;
+
+    void run();
+    bool writeBatch();
+};
@@ -19,22 +19,54 @@
 #include "directorymodel.h"
 #include <QFileInfo>
 #include <QDir>
+#include <QDateTime>
+
+void DirectoryTree::add(const WalkedDirectory &directory) {
+    DirectoryItem *parent = items.value(directory.path, root.get()); // the library root is shown as the top level
+    for (const QString &path : directory.directories)
+        if (!items.contains(path)) insert(parent, path);
+}
+
+DirectoryItem* DirectoryTree::insert(DirectoryItem *parent, const QString &path) {
+    auto *item = new DirectoryItem{
+        path,
+        path.mid(path.lastIndexOf(QLatin1Char('/')) + 1),
+        parent,
+        int(parent->children.size())
+    };
+    parent->children.append(item);
+    items.insert(path, item);
+    return item;
+}
 
 DirectoryModel::DirectoryModel(AppSettings *settings, QObject *parent)
-    : QAbstractItemModel(parent), m_root(new DirectoryItem{QString(), QString(), nullptr}), m_settings(settings)
+    : QAbstractItemModel(parent), m_settings(settings)
 {}
 
-DirectoryModel::~DirectoryModel() {
-    delete m_root;
-}
+DirectoryModel::~DirectoryModel() = default;
 
 void DirectoryModel::clear() {
-    if (m_root->children.isEmpty()) return;
+    m_building = false;
+    m_edits.clear();
+    if (m_tree.root->children.isEmpty()) return;
+
+    beginResetModel();
+    m_tree = DirectoryTree();
+    endResetModel();
+}
 
+void DirectoryModel::setTree(DirectoryTree &&tree) {
     beginResetModel();
-    qDeleteAll(m_root->children);
-    m_root->children.clear();
+    m_tree = std::move(tree);
     endResetModel();
+
+    m_building = false;
+    const QVector<QPair<bool, QString>> edits = std::move(m_edits);
+    m_edits.clear();
+    for (const auto &edit : edits) {
+        if (edit.first) addDirectory(edit.second);
+        else removeDirectory(edit.second);
+    }
 }
 
 int DirectoryModel::columnCount(const QModelIndex &) const {
@@ -46,7 +78,7 @@ QModelIndex DirectoryModel::index(int row, int column, const QModelIndex &parent
         return QModelIndex();
 
     DirectoryItem *parentItem = itemFromIndex(parent);
-    if (row >= parentItem->children.size())
+    if (!isFetched(parentItem) || row >= parentItem->children.size())
         return QModelIndex();
 
     return createIndex(row, column, parentItem->children[row]);
@@ -59,17 +91,34 @@ QModelIndex DirectoryModel::parent(const QModelIndex &child) const {
     DirectoryItem *childItem = static_cast<DirectoryItem*>(child.internalPointer());
     DirectoryItem *parentItem = childItem->parent;
 
-    if (!parentItem || parentItem == m_root)
+    if (!parentItem || parentItem == m_tree.root.get())
         return QModelIndex();
 
-    DirectoryItem *grandParent = parentItem->parent;
-    int row = grandParent ? grandParent->children.indexOf(parentItem) : 0;
-    return createIndex(row, 0, parentItem);
+    return createIndex(parentItem->row, 0, parentItem);
 }
 
 int DirectoryModel::rowCount(const QModelIndex &parent) const {
     DirectoryItem *parentItem = itemFromIndex(parent);
-    return parentItem ? parentItem->children.size() : 0;
+    return parentItem && isFetched(parentItem) ? parentItem->children.size() : 0;
+}
+
+bool DirectoryModel::hasChildren(const QModelIndex &parent) const {
+    DirectoryItem *parentItem = itemFromIndex(parent);
+    return parentItem && !parentItem->children.isEmpty();
+}
+
+bool DirectoryModel::canFetchMore(const QModelIndex &parent) const {
+    DirectoryItem *parentItem = itemFromIndex(parent);
+    return parentItem && !isFetched(parentItem) && !parentItem->children.isEmpty();
+}
+
+void DirectoryModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) return;
+
+    DirectoryItem *parentItem = itemFromIndex(parent);
+    beginInsertRows(parent, 0, parentItem->children.size() - 1);
+    parentItem->fetched = true;
+    endInsertRows();
 }
 
 QVariant DirectoryModel::data(const QModelIndex &index, int role) const {
@@ -79,6 +128,15 @@ QVariant DirectoryModel::data(const QModelIndex &index, int role) const {
     switch (role) {
         case PathRole: return item->path;
         case NameRole: return item->name;
+        case PhotoCountRole: return m_library ? m_library->photoCount(item->path) : 0;
+        case TotalBytesRole: return m_library ? m_library->bytes(item->path) : 0;
+        case FirstDateRole:
+        case LastDateRole: {
+            if (!m_library) return QDateTime();
+            const LibraryIndex::Aggregates aggregates = m_library->aggregates(item->path);
+            const qint64 date = role == FirstDateRole ? aggregates.firstDate : aggregates.lastDate;
+            return date > 0 ? QDateTime::fromMSecsSinceEpoch(date) : QDateTime();
+        }
         default: return {};
     }
 }
@@ -86,70 +144,133 @@ QVariant DirectoryModel::data(const QModelIndex &index, int role) const {
 QHash<int, QByteArray> DirectoryModel::roleNames() const {
     return {
         { PathRole, "path" },
-        { NameRole, "name" }
+        { NameRole, "name" },
+        { PhotoCountRole, "photoCount" },
+        { TotalBytesRole, "totalBytes" },
+        { FirstDateRole, "firstDate" },
+        { LastDateRole, "lastDate" }
     };
 }
 
 DirectoryItem* DirectoryModel::itemFromIndex(const QModelIndex &index) const {
     if (index.isValid()) return static_cast<DirectoryItem*>(index.internalPointer());
-    return m_root;
+    return m_tree.root.get();
 }
 
-void DirectoryModel::addDirectory(const QString &path, DirectoryItem *parentItem) {
-    QFileInfo info(path);
-    if (!info.exists() || !info.isDir())
+void DirectoryModel::addDirectory(const QString &path) {
+    // The current tree is a placeholder while building, the edit is applied to the built one
+    if (m_building) {
+        m_edits.append({ true, path });
         return;
-
-    // Determine the parent from the given path if not provided
-    if (!parentItem) {
-        QString parentPath = info.absolutePath();
-        parentItem = findItemByPath(parentPath);
-        if (!parentItem)
-            parentItem = m_root; // fallback to root
     }
+    if (m_tree.items.contains(path)) return; // already present
 
-    // Check if this directory already exists in the tree
-    for (const auto *child : parentItem->children) {
-        if (child->path == path)
-            return; // already present
+    // Paths come from the scan, no need to stat them again here
+    DirectoryItem *parentItem = findItemByPath(QFileInfo(path).absolutePath());
+    if (!parentItem) parentItem = m_tree.root.get(); // fallback to root
+
+    // Children of collapsed items are added silently, a childless item has nothing left to fetch
+    if (parentItem->children.isEmpty()) parentItem->fetched = true;
+    if (!isExposed(parentItem) || !isFetched(parentItem)) {
+        m_tree.insert(parentItem, path);
+        return;
     }
 
-    int row = parentItem->children.size();
-    QModelIndex parentIndex = (parentItem == m_root)
-        ? QModelIndex()
-        : createIndex(findRow(parentItem), 0, parentItem);
+    const int row = parentItem->children.size();
+    beginInsertRows(indexOf(parentItem), row, row);
+    m_tree.insert(parentItem, path);
+    endInsertRows();
+}
 
-    beginInsertRows(parentIndex, row, row);
+void DirectoryModel::addDirectories(const WalkedDirectory &directory) {
+    if (m_building) {
+        for (const QString &path : directory.directories)
+            m_edits.append({ true, path });
+        return;
+    }
 
-    auto *child = new DirectoryItem{
-        info.absoluteFilePath(),
-        info.fileName(),
-        parentItem
-    };
-    parentItem->children.append(child);
+    QStringList added;
+    for (const QString &path : directory.directories) {
+        if (!m_tree.items.contains(path)) added << path;
+    }
+    if (added.isEmpty()) return;
 
+    DirectoryItem *parentItem = m_tree.items.value(directory.path, m_tree.root.get());
+    if (parentItem->children.isEmpty()) parentItem->fetched = true;
+    if (!isExposed(parentItem) || !isFetched(parentItem)) {
+        for (const QString &path : added)
+            m_tree.insert(parentItem, path);
+        return;
+    }
+
+    const int first = parentItem->children.size();
+    beginInsertRows(indexOf(parentItem), first, first + int(added.size()) - 1);
+    for (const QString &path : added)
+        m_tree.insert(parentItem, path);
     endInsertRows();
 }
 
-DirectoryItem* DirectoryModel::findItemByPath(const QString &path) const {
-    if (path.isEmpty() || path == m_root->path)
-        return m_root;
+void DirectoryModel::removeDirectory(const QString &path) {
+    if (m_building) {
+        m_edits.append({ false, path });
+        return;
+    }
+    DirectoryItem *item = findItemByPath(path);
+    if (!item || item == m_tree.root.get()) return;
+
+    DirectoryItem *parentItem = item->parent;
+    const int row = item->row;
+    const bool notify = isExposed(parentItem) && isFetched(parentItem);
 
-    QList<DirectoryItem*> stack{ m_root };
+    if (notify) beginRemoveRows(indexOf(parentItem), row, row);
+    parentItem->children.removeAt(row);
+    for (int i = row; i < parentItem->children.size(); ++i)
+        parentItem->children[i]->row = i;
+
+    QList<DirectoryItem*> stack{ item };
+    while (!stack.isEmpty()) {
+        DirectoryItem *removed = stack.takeLast();
+        m_tree.items.remove(removed->path);
+        stack.append(removed->children);
+    }
+    delete item;
+    if (notify) endRemoveRows();
+}
+
+void DirectoryModel::aggregatesChanged() {
+    // Only exposed items, the others are read fresh once they are fetched
+    QList<DirectoryItem*> stack{ m_tree.root.get() };
     while (!stack.isEmpty()) {
         DirectoryItem *item = stack.takeLast();
-        if (item->path == path)
-            return item;
-        for (auto *child : item->children)
-            stack.append(child);
+        if (!isFetched(item) || item->children.isEmpty()) continue;
+
+        const QModelIndex parentIndex = indexOf(item);
+        emit dataChanged(index(0, 0, parentIndex), index(item->children.size() - 1, 0, parentIndex), {PhotoCountRole, TotalBytesRole, FirstDateRole, LastDateRole});
+        stack.append(item->children);
     }
-    return nullptr;
+}
+
+DirectoryItem* DirectoryModel::findItemByPath(const QString &path) const {
+    if (path.isEmpty() || path == m_tree.root->path)
+        return m_tree.root.get();
+    return m_tree.items.value(path, nullptr);
 }
 
 int DirectoryModel::findRow(DirectoryItem *item) const {
     if (!item || !item->parent)
         return 0;
-    return item->parent->children.indexOf(item);
+    return item->row;
+}
+
+QModelIndex DirectoryModel::indexOf(DirectoryItem *item) const {
+    if (!item || item == m_tree.root.get()) return QModelIndex();
+    return createIndex(item->row, 0, item);
+}
+
+bool DirectoryModel::isExposed(const DirectoryItem *item) const {
+    for (const DirectoryItem *parent = item->parent; parent; parent = parent->parent)
+        if (!isFetched(parent)) return false;
+    return true;
 }
 
 void DirectoryModel::setActivePath(const QString &path) {
@@ -174,7 +295,7 @@ QString DirectoryModel::getLongName(const QString &path) const {
     if (!item) return QString();
 
     QStringList names;
-    while (item && item != m_root) {
+    while (item && item != m_tree.root.get()) {
         names.prepend(item->name);
         item = item->parent;
     }
@@ -21,12 +21,17 @@
 #include <QString>
 #include <QVector>
 #include <QPointer>
+#include <QHash>
+#include <memory>
 #include "appsettings.h"
+#include "libraryindex.h"
 
 struct DirectoryItem {
     QString path;
     QString name;
     DirectoryItem* parent = nullptr;
+    int row = 0; // index in parent->children
+    bool fetched = false; // children are exposed to views, see fetchMore()
     QVector<DirectoryItem*> children;
 
     ~DirectoryItem() {
@@ -34,6 +39,16 @@ struct DirectoryItem {
     }
 };
 
+// Directory items with a path index. Plain data, so a tree can be built on a scan thread
+// and handed to the model as a whole.
+struct DirectoryTree {
+    std::unique_ptr<DirectoryItem> root = std::make_unique<DirectoryItem>();
+    QHash<QString, DirectoryItem*> items; // by path, the root is not indexed
+
+    void add(const WalkedDirectory &directory); // subdirectories of a walked directory, parents first
+    DirectoryItem* insert(DirectoryItem *parent, const QString &path);
+};
+
 class DirectoryModel : public QAbstractItemModel {
     Q_OBJECT
     Q_PROPERTY(QString activePath READ activePath WRITE setActivePath NOTIFY activePathChanged)
@@ -44,7 +59,7 @@ public:
 
     void clear();
 
-    enum Roles { PathRole = Qt::UserRole + 1, NameRole };
+    enum Roles { PathRole = Qt::UserRole + 1, NameRole, PhotoCountRole, TotalBytesRole, FirstDateRole, LastDateRole };
 
     // Basic model overrides
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
@@ -54,8 +69,22 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    // Children are known from the scan but only exposed once their parent is expanded
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
     // Public API
-    void addDirectory(const QString &path, DirectoryItem *parentItem = nullptr);
+    void addDirectory(const QString &path);
+    void addDirectories(const WalkedDirectory &directory); // its unknown subdirectories, one insertion
+    void removeDirectory(const QString &path);
+
+    // Trees built off-thread replace the current one in a single reset. Edits made while the tree
+    // is being built are only recorded and applied to it once it arrives, where their parents are.
+    void beginBuild() { m_building = true; m_edits.clear(); }
+    void setTree(DirectoryTree &&tree);
+    void setLibrary(const LibraryIndex *library) { m_library = library; }
+    void aggregatesChanged(); // photo counts, sizes and date ranges of the exposed items
 
     Q_INVOKABLE void setActivePath(const QString &path);
     QString activePath() const { return m_activePath; }
@@ -70,12 +99,18 @@ signals:
     void rootPathChanged(QString path);
 
 private:
-    DirectoryItem *m_root;
+    DirectoryTree m_tree;
+    bool m_building = false;
+    QVector<QPair<bool, QString>> m_edits; // added or removed paths while building
     QString m_rootPath;
     QString m_activePath;
     AppSettings* m_settings;
+    const LibraryIndex *m_library = nullptr; // recursive photo counts, owned by PhotoController
     DirectoryItem* itemFromIndex(const QModelIndex &index) const;
 
     DirectoryItem* findItemByPath(const QString &path) const;
     int findRow(DirectoryItem *item) const;
+    QModelIndex indexOf(DirectoryItem *item) const;
+    bool isFetched(const DirectoryItem *item) const { return item->fetched || item == m_tree.root.get(); }
+    bool isExposed(const DirectoryItem *item) const;
 };
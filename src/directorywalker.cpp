@@ -0,0 +1,357 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "directorywalker.h"
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(Q_OS_UNIX)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#else
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#endif
+
+namespace {
+
+//----- Paths -----//
+
+// Paths are kept in the native 8-bit encoding while walking and converted once per reported directory
+#if defined(Q_OS_UNIX)
+std::string toNative(const QString &path) { return QFile::encodeName(path).toStdString(); }
+QString fromNative(const std::string &path) { return QFile::decodeName(QByteArray::fromRawData(path.data(), qsizetype(path.size()))); }
+#else
+std::string toNative(const QString &path) { return path.toUtf8().toStdString(); }
+QString fromNative(const std::string &path) { return QString::fromUtf8(path.data(), qsizetype(path.size())); }
+#endif
+
+std::string joinPath(const std::string &directory, const std::string &name) {
+    std::string path;
+    path.reserve(directory.size() + name.size() + 1);
+    path += directory;
+    if (path.empty() || path.back() != '/') path += '/';
+    path += name;
+    return path;
+}
+
+bool matchesSuffix(const char *name, const std::vector<std::string> &suffixes) {
+    const char *dot = std::strrchr(name, '.');
+    if (!dot || dot == name) return false;
+    std::string suffix(dot + 1);
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](unsigned char c) { return char(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c); });
+    return std::find(suffixes.begin(), suffixes.end(), suffix) != suffixes.end();
+}
+
+//----- Listing -----//
+
+struct FileEntry {
+    std::string name;
+    int64_t size = 0;
+    int64_t modified = 0;
+    int64_t created = 0;
+
+    bool operator<(const FileEntry &other) const { return name < other.name; }
+};
+
+struct Listing {
+    std::vector<std::string> directories;
+    std::vector<FileEntry> files;
+};
+
+#if defined(Q_OS_UNIX)
+// Follows symlinks, statx on Linux only requests the fields that are used and also reports the birth time
+bool statFile(int directoryFd, const char *name, FileEntry &entry) {
+#if defined(Q_OS_LINUX) && defined(STATX_BASIC_STATS)
+    struct statx info;
+    if (::statx(directoryFd, name, 0, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_BTIME, &info) != 0 || !S_ISREG(info.stx_mode)) return false;
+    entry.size = int64_t(info.stx_size);
+    entry.modified = int64_t(info.stx_mtime.tv_sec) * 1000 + info.stx_mtime.tv_nsec / 1000000;
+    if (info.stx_mask & STATX_BTIME) entry.created = int64_t(info.stx_btime.tv_sec) * 1000 + info.stx_btime.tv_nsec / 1000000;
+#else
+    struct stat info;
+    if (::fstatat(directoryFd, name, &info, 0) != 0 || !S_ISREG(info.st_mode)) return false;
+    entry.size = int64_t(info.st_size);
+    entry.modified = int64_t(info.st_mtime) * 1000;
+#endif
+    entry.name = name;
+    return true;
+}
+
+// Sorts one entry by its d_type, directories are only stat'ed when the file system does not report a type.
+// Hidden entries are skipped and symlinked directories are not followed, like QDirIterator's defaults.
+void addEntry(int directoryFd, const char *name, unsigned char type, const std::vector<std::string> &suffixes, Listing &listing) {
+    if (name[0] == '.') return;
+
+    bool symlink = type == DT_LNK;
+    if (type == DT_UNKNOWN) {
+        struct stat info;
+        if (::fstatat(directoryFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) return;
+        symlink = S_ISLNK(info.st_mode);
+        type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+    }
+
+    if (type == DT_DIR && !symlink) {
+        listing.directories.emplace_back(name);
+        return;
+    }
+    if ((type != DT_REG && !symlink) || suffixes.empty() || !matchesSuffix(name, suffixes)) return;
+
+    FileEntry entry;
+    if (statFile(directoryFd, name, entry)) listing.files.push_back(std::move(entry));
+}
+#endif
+
+#if defined(Q_OS_LINUX)
+// Kernel layout of getdents64 records
+struct KernelDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+void listDirectory(const std::string &path, const std::vector<std::string> &suffixes, Listing &listing) {
+    const int fd = ::openat(AT_FDCWD, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    alignas(8) char buffer[32 * 1024];
+    for (;;) {
+        const long bytes = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (bytes <= 0) break;
+        for (long offset = 0; offset < bytes;) {
+            const auto *entry = reinterpret_cast<const KernelDirent64 *>(buffer + offset);
+            offset += entry->d_reclen;
+            addEntry(fd, entry->d_name, entry->d_type, suffixes, listing);
+        }
+    }
+    ::close(fd);
+}
+#elif defined(Q_OS_UNIX)
+void listDirectory(const std::string &path, const std::vector<std::string> &suffixes, Listing &listing) {
+    const int fd = ::openat(AT_FDCWD, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    DIR *directory = ::fdopendir(fd);
+    if (!directory) {
+        ::close(fd);
+        return;
+    }
+
+    while (const dirent *entry = ::readdir(directory))
+        addEntry(fd, entry->d_name, entry->d_type, suffixes, listing);
+    ::closedir(directory);
+}
+#else
+// Portable fallback, one non-recursive QDirIterator per directory
+void listDirectory(const std::string &path, const std::vector<std::string> &suffixes, Listing &listing) {
+    QDirIterator it(fromNative(path), QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        const std::string name = toNative(info.fileName());
+        if (info.isDir()) {
+            if (!info.isSymLink()) listing.directories.push_back(name);
+        }
+        else if (!suffixes.empty() && matchesSuffix(name.c_str(), suffixes)) {
+            const QDateTime created = info.birthTime();
+            listing.files.push_back({ name, info.size(), info.lastModified().toMSecsSinceEpoch(), created.isValid() ? created.toMSecsSinceEpoch() : 0 });
+        }
+    }
+}
+#endif
+
+//----- Walk -----//
+
+struct Node {
+    std::string path;
+    std::vector<FileEntry> files;
+    std::vector<std::unique_ptr<Node>> children; // sorted by name
+    std::atomic<bool> claimed {false};           // by the task or the consumer that lists it
+    bool listed = false;                         // guarded by Walk::m_resultMutex
+};
+
+// Lists a node and creates its (not yet listed) children
+void listNode(Node *node, const std::vector<std::string> &suffixes) {
+    Listing listing;
+    listDirectory(node->path, suffixes, listing);
+    std::sort(listing.directories.begin(), listing.directories.end());
+    std::sort(listing.files.begin(), listing.files.end());
+
+    node->files = std::move(listing.files);
+    node->children.reserve(listing.directories.size());
+    for (const std::string &name : listing.directories) {
+        auto child = std::make_unique<Node>();
+        child->path = joinPath(node->path, name);
+        node->children.push_back(std::move(child));
+    }
+}
+
+WalkedDirectory toWalkedDirectory(const Node *node) {
+    WalkedDirectory directory;
+    directory.path = fromNative(node->path);
+    directory.directories.reserve(qsizetype(node->children.size()));
+    for (const auto &child : node->children)
+        directory.directories << fromNative(child->path);
+    directory.files.reserve(qsizetype(node->files.size()));
+    for (const FileEntry &file : node->files)
+        directory.files.append({ fromNative(file.name), file.size, file.modified, file.created });
+    directory.summarize();
+    return directory;
+}
+
+// Every directory is listed by its own I/O lane task, so a walk shares the lane with metadata reads and
+// settings writes instead of holding workers for its whole duration. The consumer should run outside the lane,
+// it lists the next directory itself when no task has claimed it yet, which keeps a walk going while the lane
+// is busy with other work.
+class Walk {
+public:
+    Walk(TaskScheduler &scheduler, TaskScheduler::Priority priority, const std::vector<std::string> &suffixes, const CancellationToken &cancellation)
+        : m_suffixes(suffixes), m_cancellation(cancellation), m_priority(priority), m_tasks(Metrics::LoadingPool, scheduler) {}
+
+    void run(Node *root, const std::function<bool(Node *)> &consume) {
+        // Report in pre-order, waiting for each directory until a task has listed it
+        std::vector<Node *> stack { root };
+        while (!stack.empty()) {
+            Node *node = stack.back();
+            stack.pop_back();
+            if (!node->claimed.exchange(true)) process(node);
+            else {
+                // Cancelling does not notify, poll so a slow directory cannot hold up the cancellation
+                std::unique_lock<std::mutex> lock(m_resultMutex);
+                while (!m_resultReady.wait_for(lock, std::chrono::milliseconds(50), [node] { return node->listed; })) {
+                    if (m_cancellation.isCancelled()) break;
+                }
+            }
+            if (m_cancellation.isCancelled() || !consume(node)) break;
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                stack.push_back(it->get());
+        }
+
+        // No task submits after this, so only running listings are waited for
+        {
+            std::lock_guard<std::mutex> lock(m_submitMutex);
+            m_stop = true;
+        }
+        m_tasks.clear();
+        m_tasks.waitForDone();
+    }
+
+private:
+    std::vector<std::string> m_suffixes;
+    CancellationToken m_cancellation;
+    TaskScheduler::Priority m_priority;
+
+    std::mutex m_submitMutex;
+    bool m_stop = false; // guarded by m_submitMutex
+    std::mutex m_resultMutex;
+    std::condition_variable m_resultReady;
+
+    TaskGroup m_tasks; // last, its destructor waits for tasks that refer to the members above
+
+    void process(Node *node) {
+        listNode(node, m_suffixes);
+
+        if (!node->children.empty()) {
+            std::lock_guard<std::mutex> lock(m_submitMutex);
+            if (!m_stop) {
+                for (const auto &child : node->children) {
+                    Node *next = child.get();
+                    m_tasks.run(m_priority, TaskScheduler::IoLane, [this, next]() {
+                        if (m_cancellation.isCancelled() || next->claimed.exchange(true)) return;
+                        process(next);
+                    });
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_resultMutex);
+            node->listed = true;
+        }
+        m_resultReady.notify_all();
+    }
+};
+
+} // namespace
+
+void WalkedDirectory::summarize() {
+    bytes = 0;
+    firstDate = 0;
+    lastDate = 0;
+    for (const WalkedFile &file : files) {
+        bytes += file.size;
+        const qint64 date = file.created > 0 ? file.created : file.modified;
+        if (date == 0) continue;
+        firstDate = firstDate == 0 ? date : std::min(firstDate, date);
+        lastDate = std::max(lastDate, date);
+    }
+}
+
+DirectoryWalker::DirectoryWalker(const QStringList &fileSuffixes, TaskScheduler::Priority priority, TaskScheduler &scheduler)
+    : m_priority(priority), m_scheduler(scheduler)
+{
+    for (const QString &suffix : fileSuffixes)
+        m_suffixes << suffix.toLower();
+}
+
+void DirectoryWalker::walk(const QString &root, const Callback &onDirectory, const CancellationToken &cancellation) const {
+    if (root.isEmpty()) return;
+
+    auto rootNode = std::make_unique<Node>();
+    rootNode->path = toNative(QDir::cleanPath(root));
+
+    Walk walk(m_scheduler, m_priority, nativeSuffixes(), cancellation);
+    walk.run(rootNode.get(), [&onDirectory](Node *node) {
+        const WalkedDirectory directory = toWalkedDirectory(node);
+
+        // File entries are no longer needed once reported
+        std::vector<FileEntry>().swap(node->files);
+        return onDirectory(directory);
+    });
+}
+
+WalkedDirectory DirectoryWalker::list(const QString &directory) const {
+    Node node;
+    node.path = toNative(QDir::cleanPath(directory));
+    listNode(&node, nativeSuffixes());
+    return toWalkedDirectory(&node);
+}
+
+std::vector<std::string> DirectoryWalker::nativeSuffixes() const {
+    std::vector<std::string> suffixes;
+    suffixes.reserve(m_suffixes.size());
+    for (const QString &suffix : m_suffixes)
+        suffixes.push_back(toNative(suffix));
+    return suffixes;
+}
@@ -0,0 +1,72 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "cancellationtoken.h"
+#include "taskscheduler.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct WalkedFile {
+    QString name;
+    qint64 size = 0;
+    qint64 modified = 0; // msecs since epoch
+    qint64 created = 0;  // msecs since epoch, 0 where the file system does not record it
+};
+
+struct WalkedDirectory {
+    QString path;             // absolute path
+    QStringList directories;  // paths of subdirectories, sorted by name
+    QVector<WalkedFile> files; // matching files, sorted by name
+
+    // Summary of the files, filled in by summarize() on the thread that walked them
+    qint64 bytes = 0;
+    qint64 firstDate = 0; // msecs since epoch, creation time where known (0 without dated files)
+    qint64 lastDate = 0;
+
+    void summarize();
+};
+
+// Parallel directory tree walker. Each subdirectory is listed by a task on the scheduler's I/O lane,
+// results are reported on the calling thread in deterministic order (parents before children, siblings sorted by name).
+class DirectoryWalker {
+public:
+    using Callback = std::function<bool(const WalkedDirectory &directory)>; // return false to stop the walk
+
+    // fileSuffixes are matched case-insensitively without the dot, no files are collected if empty.
+    // Size and modification time of matching files come from the same stat call that resolves their type.
+    // Listings run at the given priority, below metadata reads by default.
+    explicit DirectoryWalker(const QStringList &fileSuffixes = {}, TaskScheduler::Priority priority = TaskScheduler::Background,
+                             TaskScheduler &scheduler = TaskScheduler::instance());
+
+    // Cancelling drops the queued listings and returns without reporting further directories.
+    // Blocks while listings are pending, call it from the coordinator lane or a thread outside the scheduler.
+    void walk(const QString &root, const Callback &onDirectory, const CancellationToken &cancellation = {}) const;
+    WalkedDirectory list(const QString &directory) const; // one directory without descending, on the calling thread
+
+private:
+    QStringList m_suffixes;
+    TaskScheduler::Priority m_priority;
+    TaskScheduler &m_scheduler;
+
+    std::vector<std::string> nativeSuffixes() const;
+};
@@ -17,15 +17,19 @@
 */
 
 #include "exifregistry.h"
-#include <QtConcurrent>
+#include "tracing.h"
+#include "metrics.h"
+#include <QMetaObject>
 #include <QDebug>
+#include <algorithm>
+#include <memory>
 
 ExifRegistry::ExifRegistry(QObject *parent)
     : QObject(parent) {}
 
 ExifRegistry::~ExifRegistry() {
-    m_threadPool.clear();
-    m_threadPool.waitForDone();
+    m_tasks.clear();
+    m_tasks.waitForDone();
 }
 
 ExifData ExifRegistry::getData(const QString &filePath) const {
@@ -37,91 +41,156 @@ void ExifRegistry::requestData(int index, const QString &filePath) {
     QMutexLocker locker(&m_mutex);
     if(m_resultMap.contains(filePath)) return;
     m_pathList.append(filePath);
-    if (m_firstRequestedIndex < 0) m_firstRequestedIndex = index;
-    m_lastRequestedIndex = index;
+    m_firstRequestedIndex = m_firstRequestedIndex < 0 ? index : std::min(m_firstRequestedIndex, index);
+    m_lastRequestedIndex = std::max(m_lastRequestedIndex, index);
+}
+
+void ExifRegistry::requestData(int firstIndex, const QStringList &filePaths) {
+    if (filePaths.isEmpty()) return;
+
+    QMutexLocker locker(&m_mutex);
+    m_pathList.reserve(m_pathList.size() + filePaths.size());
+    for (const QString &filePath : filePaths)
+        if (!m_resultMap.contains(filePath)) m_pathList.append(filePath);
+
+    const int lastIndex = firstIndex + int(filePaths.size()) - 1;
+    m_firstRequestedIndex = m_firstRequestedIndex < 0 ? firstIndex : std::min(m_firstRequestedIndex, firstIndex);
+    m_lastRequestedIndex = std::max(m_lastRequestedIndex, lastIndex);
+}
+
+void ExifRegistry::invalidate(const QString &filePath) {
+    QMutexLocker locker(&m_mutex);
+    m_resultMap.remove(filePath);
+}
+
+QHash<QString, ExifData> ExifRegistry::knownData(const QStringList &filePaths) const {
+    QHash<QString, ExifData> result;
+    QMutexLocker locker(&m_mutex);
+    for (const QString &filePath : filePaths) {
+        auto it = m_resultMap.constFind(filePath);
+        if (it != m_resultMap.cend()) result.insert(filePath, it.value());
+    }
+    return result;
+}
+
+void ExifRegistry::restore(const QHash<QString, ExifData> &data) {
+    QMutexLocker locker(&m_mutex);
+    m_resultMap.insert(data);
+}
+
+void ExifRegistry::cancelPending() {
+    m_cancellation.cancel();
+    m_cancellation = CancellationToken();
+    m_runningBatches = 0; // cancelled batches never report
+
+    QMutexLocker locker(&m_mutex);
+    m_pathList.clear();
+    m_firstRequestedIndex = -1;
+    m_lastRequestedIndex = -1;
 }
 
 void ExifRegistry::startProcessing() {
+    // Take the pending batch, so new requests can queue up while this one is processed
+    auto batch = std::make_shared<QVector<QString>>();
+    int firstIndex = -1;
+    int lastIndex = -1;
+    const CancellationToken cancellation = m_cancellation;
     {
         QMutexLocker locker(&m_mutex);
-        if (m_pathList.isEmpty()) {
-            clearQueue();
-            return;
-        }
+        batch->swap(m_pathList);
+        std::swap(firstIndex, m_firstRequestedIndex);
+        std::swap(lastIndex, m_lastRequestedIndex);
     }
 
-    QFuture<void> future = QtConcurrent::map(&m_threadPool, m_pathList, [this](const QString &filePath) {
-        try {
-            Exiv2::Image::UniquePtr image = Exiv2::ImageFactory::open(filePath.toStdString());
-            if (!image) return;
+    if (batch->isEmpty()) {
+        emit dataReady(firstIndex, lastIndex);
+        return;
+    }
 
-            image->readMetadata();
-            Exiv2::ExifData &exifData = image->exifData();
-            if (exifData.empty()) return;
+    // Chunks are small enough for thumbnails and photo views to get between them. The batch stays alive
+    // until its last chunk is processed, which reports it on the GUI thread.
+    ++m_runningBatches;
+    const int chunks = int((batch->size() + ChunkFiles - 1) / ChunkFiles);
+    auto remaining = std::make_shared<std::atomic<int>>(chunks);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        m_tasks.run(TaskScheduler::Metadata, TaskScheduler::IoLane, [this, batch, chunk, remaining, firstIndex, lastIndex, cancellation]() {
+            const int end = std::min(int(batch->size()), (chunk + 1) * ChunkFiles);
+            for (int i = chunk * ChunkFiles; i < end && !cancellation.isCancelled(); ++i) { // the rows it was requested for may be gone
+                ExifData data;
+                if (!extract(batch->at(i), data)) continue;
 
-            ExifData data;
+                QMutexLocker locker(&m_mutex);
+                m_resultMap[batch->at(i)] = data;
+            }
 
-            // Camera / lens
-            data.maker = getExifString(exifData, "Exif.Image.Make");
-            data.cameraModel = getExifString(exifData, "Exif.Image.Model");
-            data.lensModel = getExifString(exifData, {"Exif.Photo.LensModel", "Exif.Photo.LensSpecification", "Exif.Photo.LensMake"});
+            if (remaining->fetch_sub(1) != 1) return;
+            QMetaObject::invokeMethod(this, [this, firstIndex, lastIndex, cancellation]() {
+                if (cancellation.isCancelled()) return;
+                --m_runningBatches;
+                emit dataReady(firstIndex, lastIndex);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
 
-            // Date
-            data.dateTaken = QDateTime::fromString(getExifString(exifData, {"Exif.Photo.DateTimeOriginal", "Exif.Photo.CreationDate", "Exif.Image.DateTime"}), "yyyy:MM:dd HH:mm:ss");
+bool ExifRegistry::extract(const QString &filePath, ExifData &data) {
+    LYSA_TRACE_SCOPE("exif", "ExifRegistry::read");
+    try {
+        Exiv2::Image::UniquePtr image;
+        {
+            LYSA_TRACE_SCOPE("exif", "Exiv2::readMetadata");
+            Metrics::LatencyScope latency(Metrics::ExifRead);
+            image = Exiv2::ImageFactory::open(filePath.toStdString());
+            if (!image) return false;
+            image->readMetadata();
+        }
+        Exiv2::ExifData &exifData = image->exifData();
+        if (exifData.empty()) return false;
 
-            // ISO
-            data.iso = getExifInt(exifData, {"Exif.Photo.ISOSpeed", "Exif.Photo.SensitivityType", "Exif.Photo.ISOSpeedRatings"});
+        // Camera / lens
+        data.maker = getExifString(exifData, "Exif.Image.Make");
+        data.cameraModel = getExifString(exifData, "Exif.Image.Model");
+        data.lensModel = getExifString(exifData, {"Exif.Photo.LensModel", "Exif.Photo.LensSpecification", "Exif.Photo.LensMake"});
 
-            // Aperture
-            data.aperture = getExifRational(exifData, "Exif.Photo.FNumber", RationalType::Aperture);
+        // Date
+        data.dateTaken = QDateTime::fromString(getExifString(exifData, {"Exif.Photo.DateTimeOriginal", "Exif.Photo.CreationDate", "Exif.Image.DateTime"}), "yyyy:MM:dd HH:mm:ss");
 
-            // Focal Length
-            data.focalLength = getExifRational(exifData, "Exif.Photo.FocalLength", RationalType::FocalLength);
+        // ISO
+        data.iso = getExifInt(exifData, {"Exif.Photo.ISOSpeed", "Exif.Photo.SensitivityType", "Exif.Photo.ISOSpeedRatings"});
 
-            // Exposure
-            data.exposureTime = getExifRational(exifData, "Exif.Photo.ExposureTime", RationalType::Shutter);
-            data.exposureBias = getExifRational(exifData, "Exif.Photo.ExposureBiasValue", RationalType::Bias);
+        // Aperture
+        data.aperture = getExifRational(exifData, "Exif.Photo.FNumber", RationalType::Aperture);
 
-            // Flash
-            data.flashFired = getExifInt(exifData, "Exif.Photo.Flash");
+        // Focal Length
+        data.focalLength = getExifRational(exifData, "Exif.Photo.FocalLength", RationalType::FocalLength);
 
-            // Software
-            data.software = getExifString(exifData, "Exif.Image.Software");
+        // Exposure
+        data.exposureTime = getExifRational(exifData, "Exif.Photo.ExposureTime", RationalType::Shutter);
+        data.exposureBias = getExifRational(exifData, "Exif.Photo.ExposureBiasValue", RationalType::Bias);
 
-            // Orientation
-            data.orientation = getExifInt(exifData, "Exif.Image.Orientation");
+        // Flash
+        data.flashFired = getExifInt(exifData, "Exif.Photo.Flash");
 
-            // Dimensions
-            data.width = getExifInt(exifData, {"Exif.Photo.PixelXDimension", "Exif.Image.ImageWidth"});
-            data.height = getExifInt(exifData, {"Exif.Photo.PixelYDimension", "Exif.Image.ImageLength"});
+        // Software
+        data.software = getExifString(exifData, "Exif.Image.Software");
 
-            // GPS
-            data.gpsLatitude = applyGpsRef(getExifGpsCoord(exifData, "Exif.GPSInfo.GPSLatitude"), getExifString(exifData, "Exif.GPSInfo.GPSLatitudeRef"));
-            data.gpsLongitude = applyGpsRef(getExifGpsCoord(exifData, "Exif.GPSInfo.GPSLongitude"), getExifString(exifData, "Exif.GPSInfo.GPSLongitudeRef"));
-            data.gpsAltitude = getExifGpsAltitude(exifData);
+        // Orientation
+        data.orientation = getExifInt(exifData, "Exif.Image.Orientation");
 
+        // Dimensions
+        data.width = getExifInt(exifData, {"Exif.Photo.PixelXDimension", "Exif.Image.ImageWidth"});
+        data.height = getExifInt(exifData, {"Exif.Photo.PixelYDimension", "Exif.Image.ImageLength"});
 
-            {
-                QMutexLocker locker(&m_mutex);
-                m_resultMap[filePath] = data;
-            }
-        }
-        catch (const Exiv2::Error &e) {
-            //qWarning() << "Failed to load EXIF metadata for" << filePath << ":" << e.what();
-        }
-    });
-
-    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
-    connect(watcher, &QFutureWatcher<void>::finished, this, &ExifRegistry::clearQueue);
-    connect(watcher, &QFutureWatcher<void>::finished, watcher, &QObject::deleteLater);
-    watcher->setFuture(future);
-}
-
-void ExifRegistry::clearQueue() {
-    emit dataReady(m_firstRequestedIndex, m_lastRequestedIndex);
-    m_firstRequestedIndex = -1;
-    m_lastRequestedIndex = -1;
-    m_pathList.clear();
+        // GPS
+        data.gpsLatitude = applyGpsRef(getExifGpsCoord(exifData, "Exif.GPSInfo.GPSLatitude"), getExifString(exifData, "Exif.GPSInfo.GPSLatitudeRef"));
+        data.gpsLongitude = applyGpsRef(getExifGpsCoord(exifData, "Exif.GPSInfo.GPSLongitude"), getExifString(exifData, "Exif.GPSInfo.GPSLongitudeRef"));
+        data.gpsAltitude = getExifGpsAltitude(exifData);
+        return true;
+    }
+    catch (const Exiv2::Error &e) {
+        //qWarning() << "Failed to load EXIF metadata for" << filePath << ":" << e.what();
+        return false;
+    }
 }
 
 QString ExifRegistry::getExifString(const Exiv2::ExifData &exifData, const char* key) {
@@ -18,7 +18,6 @@
 
 #pragma once
 #include <QObject>
-#include <QThreadPool>
 #include <QString>
 #include <QDateTime>
 #include <QDebug>
@@ -26,6 +25,8 @@
 #include <QMutexLocker>
 #include <exiv2/exiv2.hpp>
 #include "structs.h"
+#include "cancellationtoken.h"
+#include "taskscheduler.h"
 
 class ExifRegistry : public QObject {
     Q_OBJECT
@@ -34,20 +35,29 @@ public:
     ~ExifRegistry();
     ExifData getData(const QString &filePath) const;
     void requestData(int index, const QString &filePath);
+    void requestData(int firstIndex, const QStringList &filePaths); // consecutive rows, one lock for the batch
+    void invalidate(const QString &filePath);
+    QHash<QString, ExifData> knownData(const QStringList &filePaths) const; // skips files without metadata
+    void restore(const QHash<QString, ExifData> &data);
     void startProcessing();
+    void cancelPending(); // drops queued requests, running batches stop at the next file
+    bool isProcessing() const { return m_runningBatches > 0; } // GUI thread, batches not reported yet
+    bool extract(const QString &filePath, ExifData &data); // one file on the calling thread, false without metadata
 
 signals:
     void dataReady(int firstIndex, int lastIndex);
 
 private:
+    static constexpr int ChunkFiles = 16; // files per task
+
     mutable QMutex m_mutex;
-    QThreadPool m_threadPool;
+    TaskGroup m_tasks { Metrics::ExifPool };
     QHash<QString, ExifData> m_resultMap;
     QVector<QString> m_pathList;
     int m_firstRequestedIndex = -1;
     int m_lastRequestedIndex = -1;
-
-    void clearQueue();
+    CancellationToken m_cancellation; // of the batches started since the last cancelPending()
+    int m_runningBatches = 0;
 
     QString getExifString(const Exiv2::ExifData &exifData, const char* key);
     QString getExifString(const Exiv2::ExifData &exifData, std::initializer_list<const char*> keys);
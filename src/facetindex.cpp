@@ -0,0 +1,206 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "facetindex.h"
+#include <algorithm>
+
+void FacetIndex::clear() {
+    m_rowCount = 0;
+    m_cameras.clear();
+    m_lenses.clear();
+    m_iso.clear();
+    m_dates.clear();
+    m_focalLengths.clear();
+    m_changedRows.clear();
+}
+
+void FacetIndex::reserve(int rows) {
+    m_cameras.rowIds.reserve(rows);
+    m_lenses.rowIds.reserve(rows);
+    m_iso.entries.reserve(rows);
+    m_dates.entries.reserve(rows);
+    m_focalLengths.entries.reserve(rows);
+    m_iso.values.reserve(rows);
+    m_dates.values.reserve(rows);
+    m_focalLengths.values.reserve(rows);
+}
+
+void FacetIndex::addRow(const QString &cameraModel, const QString &lensModel, int iso, qint64 date, double focalLength) {
+    const uint32_t row = uint32_t(m_rowCount++);
+    m_cameras.add(cameraModel);
+    m_lenses.add(lensModel);
+    m_iso.add(iso, row);
+    m_dates.add(date, row);
+    m_focalLengths.add(focalLength, row);
+}
+
+void FacetIndex::finalize() {
+    m_cameras.build(m_rowCount);
+    m_lenses.build(m_rowCount);
+    std::sort(m_iso.entries.begin(), m_iso.entries.end());
+    std::sort(m_dates.entries.begin(), m_dates.entries.end());
+    std::sort(m_focalLengths.entries.begin(), m_focalLengths.entries.end());
+}
+
+void FacetIndex::setRow(int row, const QString &cameraModel, const QString &lensModel, int iso, qint64 date, double focalLength) {
+    if (row == m_rowCount) {
+        ++m_rowCount;
+        m_cameras.resize(m_rowCount);
+        m_lenses.resize(m_rowCount);
+        m_iso.values.push_back(iso);
+        m_dates.values.push_back(date);
+        m_focalLengths.values.push_back(focalLength);
+    }
+    m_cameras.set(uint32_t(row), cameraModel, m_rowCount);
+    m_lenses.set(uint32_t(row), lensModel, m_rowCount);
+    m_iso.values[row] = iso;
+    m_dates.values[row] = date;
+    m_focalLengths.values[row] = focalLength;
+    m_changedRows.push_back(uint32_t(row));
+}
+
+void FacetIndex::commit() {
+    if (m_changedRows.empty()) return;
+    std::sort(m_changedRows.begin(), m_changedRows.end());
+    m_changedRows.erase(std::unique(m_changedRows.begin(), m_changedRows.end()), m_changedRows.end());
+
+    std::vector<bool> changed(size_t(m_rowCount), false);
+    for (uint32_t row : m_changedRows)
+        changed[row] = true;
+    m_iso.update(m_changedRows, changed);
+    m_dates.update(m_changedRows, changed);
+    m_focalLengths.update(m_changedRows, changed);
+    m_changedRows.clear();
+}
+
+FacetIndex::Bitmap FacetIndex::evaluate(const Filter &filter) const {
+    Bitmap result(wordCount(m_rowCount), ~uint64_t(0));
+    if (m_rowCount % 64 != 0)
+        result.back() = (uint64_t(1) << (m_rowCount % 64)) - 1;
+
+    if (!filter.cameraModels.isEmpty())
+        andWith(result, m_cameras.match(filter.cameraModels, m_rowCount));
+    if (!filter.lensModels.isEmpty())
+        andWith(result, m_lenses.match(filter.lensModels, m_rowCount));
+    if (filter.hasIsoRange())
+        andWith(result, m_iso.range(filter.isoMin, filter.isoMax, m_rowCount));
+    if (filter.hasDateRange()) // rows without a date are stored as min() and never match
+        andWith(result, m_dates.range(std::max(filter.dateFrom, std::numeric_limits<qint64>::min() + 1), filter.dateTo, m_rowCount));
+    if (filter.hasFocalLengthRange())
+        andWith(result, m_focalLengths.range(filter.focalLengthMin, filter.focalLengthMax, m_rowCount));
+
+    return result;
+}
+
+bool FacetIndex::matches(const Filter &filter, int row) const {
+    if (!filter.cameraModels.isEmpty() && !filter.cameraModels.contains(m_cameras.values[m_cameras.rowIds[row]])) return false;
+    if (!filter.lensModels.isEmpty() && !filter.lensModels.contains(m_lenses.values[m_lenses.rowIds[row]])) return false;
+
+    const int iso = m_iso.values[row];
+    if (filter.hasIsoRange() && (iso < filter.isoMin || iso > filter.isoMax)) return false;
+    const qint64 date = m_dates.values[row];
+    if (filter.hasDateRange() && (date == std::numeric_limits<qint64>::min() || date < filter.dateFrom || date > filter.dateTo)) return false;
+    const double focalLength = m_focalLengths.values[row];
+    if (filter.hasFocalLengthRange() && (focalLength < filter.focalLengthMin || focalLength > filter.focalLengthMax)) return false;
+    return true;
+}
+
+void FacetIndex::andWith(Bitmap &result, const Bitmap &other) {
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] &= other[i];
+}
+
+
+//----- Categorical facets -----//
+void FacetIndex::Categorical::clear() {
+    ids.clear();
+    values.clear();
+    rowIds.clear();
+    bitmaps.clear();
+}
+
+uint32_t FacetIndex::Categorical::intern(const QString &value) {
+    auto it = ids.constFind(value);
+    if (it == ids.cend()) {
+        it = ids.insert(value, uint32_t(values.size()));
+        values.append(value);
+    }
+    return it.value();
+}
+
+void FacetIndex::Categorical::set(uint32_t row, const QString &value, int rowCount) {
+    const uint32_t id = intern(value);
+    if (id == bitmaps.size()) bitmaps.emplace_back(wordCount(rowCount), 0);
+    if (row < rowIds.size()) {
+        clearBit(bitmaps[rowIds[row]], row);
+        rowIds[row] = id;
+    }
+    else rowIds.push_back(id);
+    setBit(bitmaps[id], row);
+}
+
+void FacetIndex::Categorical::resize(int rowCount) {
+    const size_t words = wordCount(rowCount);
+    if (!bitmaps.empty() && bitmaps.front().size() == words) return;
+    for (Bitmap &bitmap : bitmaps)
+        bitmap.resize(words, 0);
+}
+
+void FacetIndex::Categorical::build(int rowCount) {
+    bitmaps.assign(values.size(), Bitmap(wordCount(rowCount), 0));
+    for (size_t row = 0; row < rowIds.size(); ++row)
+        setBit(bitmaps[rowIds[row]], uint32_t(row));
+}
+
+FacetIndex::Bitmap FacetIndex::Categorical::match(const QStringList &selected, int rowCount) const {
+    Bitmap result(wordCount(rowCount), 0);
+    for (const QString &value : selected) {
+        auto it = ids.constFind(value);
+        if (it == ids.cend()) continue;
+        const Bitmap &bitmap = bitmaps[it.value()];
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] |= bitmap[i];
+    }
+    return result;
+}
+
+
+//----- Numeric facets -----//
+template<typename T>
+void FacetIndex::Sorted<T>::update(const std::vector<uint32_t> &rows, const std::vector<bool> &changed) {
+    // Changed rows leave and come back with their new values, merged into the rest instead of a full sort
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&changed](const std::pair<T, uint32_t> &entry) { return changed[entry.second]; }),
+                  entries.end());
+    const size_t middle = entries.size();
+    for (uint32_t row : rows)
+        entries.emplace_back(values[row], row);
+    std::sort(entries.begin() + middle, entries.end());
+    std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end());
+}
+
+template<typename T>
+FacetIndex::Bitmap FacetIndex::Sorted<T>::range(T min, T max, int rowCount) const {
+    Bitmap result(wordCount(rowCount), 0);
+    auto first = std::lower_bound(entries.begin(), entries.end(), min,
+        [](const std::pair<T, uint32_t> &entry, T value) { return entry.first < value; });
+    auto last = std::upper_bound(first, entries.end(), max,
+        [](T value, const std::pair<T, uint32_t> &entry) { return value < entry.first; });
+    for (auto it = first; it != last; ++it)
+        setBit(result, it->second);
+    return result;
+}
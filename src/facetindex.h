@@ -0,0 +1,109 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+// Per-facet indexes over source rows: bitmaps for categorical values, sorted arrays for numeric ranges
+class FacetIndex {
+public:
+    using Bitmap = std::vector<uint64_t>;
+
+    struct Filter {
+        QStringList cameraModels; // empty = any
+        QStringList lensModels;   // empty = any
+        int isoMin = 0;
+        int isoMax = std::numeric_limits<int>::max();
+        qint64 dateFrom = std::numeric_limits<qint64>::min(); // msecs since epoch
+        qint64 dateTo = std::numeric_limits<qint64>::max();
+        double focalLengthMin = 0.0;
+        double focalLengthMax = std::numeric_limits<double>::max();
+
+        bool hasIsoRange() const { return isoMin > 0 || isoMax < std::numeric_limits<int>::max(); }
+        bool hasDateRange() const { return dateFrom > std::numeric_limits<qint64>::min() || dateTo < std::numeric_limits<qint64>::max(); }
+        bool hasFocalLengthRange() const { return focalLengthMin > 0.0 || focalLengthMax < std::numeric_limits<double>::max(); }
+        bool isActive() const {
+            return !cameraModels.isEmpty() || !lensModels.isEmpty() || hasIsoRange() || hasDateRange() || hasFocalLengthRange();
+        }
+    };
+
+    // Bulk build
+    void clear();
+    void reserve(int rows);
+    void addRow(const QString &cameraModel, const QString &lensModel, int iso, qint64 date, double focalLength);
+    void finalize();
+
+    // Incremental upkeep of a built index: rows change in place, row == rowCount() appends.
+    // Categorical facets are current right away, the sorted ones after commit().
+    void setRow(int row, const QString &cameraModel, const QString &lensModel, int iso, qint64 date, double focalLength);
+    void commit();
+
+    int rowCount() const { return m_rowCount; }
+    QStringList cameraModels() const { return m_cameras.values; }
+    QStringList lensModels() const { return m_lenses.values; }
+
+    Bitmap evaluate(const Filter &filter) const;
+    bool matches(const Filter &filter, int row) const; // one row, without building bitmaps
+    static bool test(const Bitmap &bitmap, int row) { return (bitmap[size_t(row) >> 6] >> (row & 63)) & 1u; }
+
+private:
+    struct Categorical {
+        QHash<QString, uint32_t> ids;
+        QStringList values;
+        std::vector<uint32_t> rowIds;
+        std::vector<Bitmap> bitmaps;
+
+        void clear();
+        uint32_t intern(const QString &value);
+        void add(const QString &value) { rowIds.push_back(intern(value)); }
+        void set(uint32_t row, const QString &value, int rowCount);
+        void build(int rowCount);
+        void resize(int rowCount);
+        Bitmap match(const QStringList &selected, int rowCount) const;
+    };
+
+    template<typename T>
+    struct Sorted {
+        std::vector<std::pair<T, uint32_t>> entries; // (value, row), sorted by value after finalize()
+        std::vector<T> values;                       // by row
+
+        void clear() { entries.clear(); values.clear(); }
+        void add(T value, uint32_t row) { entries.emplace_back(value, row); values.push_back(value); }
+        void update(const std::vector<uint32_t> &rows, const std::vector<bool> &changed);
+        Bitmap range(T min, T max, int rowCount) const;
+    };
+
+    int m_rowCount = 0;
+    Categorical m_cameras;
+    Categorical m_lenses;
+    Sorted<int> m_iso;
+    Sorted<qint64> m_dates;
+    Sorted<double> m_focalLengths;
+    std::vector<uint32_t> m_changedRows; // set since the last commit()
+
+    static size_t wordCount(int rowCount) { return (size_t(rowCount) + 63) / 64; }
+    static void setBit(Bitmap &bitmap, uint32_t row) { bitmap[row >> 6] |= uint64_t(1) << (row & 63); }
+    static void clearBit(Bitmap &bitmap, uint32_t row) { bitmap[row >> 6] &= ~(uint64_t(1) << (row & 63)); }
+    static void andWith(Bitmap &result, const Bitmap &other);
+};
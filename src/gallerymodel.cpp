@@ -17,27 +17,44 @@
 */
 
 #include "gallerymodel.h"
+#include "tracing.h"
+#include "metrics.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
 
 GalleryModel::GalleryModel(AppSettings *settings, PhotoModel& sourceModel, QObject *parent)
-    : QSortFilterProxyModel(parent), m_settings(settings), m_source(sourceModel)
+    : QAbstractListModel(parent), m_settings(settings), m_source(sourceModel)
 {
-    setDynamicSortFilter(false); //Handled by custom connection to prevent unnecessary re-sorting
+    // Sorting is triggered by the custom connections below to prevent unnecessary re-sorting
+    onSourceReset();
     loadSettings();
 
-    setSourceModel(&m_source);
-
     connect(m_settings, &AppSettings::settingChanged,
             this, &GalleryModel::onSettingChanged);
 
     connect(&m_source, &QAbstractItemModel::dataChanged,
-        this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
-        emit dataChanged(mapFromSource(topLeft), mapFromSource(bottomRight), roles);
-        if (roles.isEmpty() || roles.contains(m_sortMode)) sort();
+            this, &GalleryModel::onSourceDataChanged);
+    connect(&m_source, &QAbstractItemModel::rowsInserted,
+            this, &GalleryModel::onSourceRowsInserted);
+    connect(&m_source, &QAbstractItemModel::rowsAboutToBeRemoved,
+            this, &GalleryModel::onSourceRowsAboutToBeRemoved);
+    connect(&m_source, &QAbstractItemModel::rowsRemoved,
+            this, &GalleryModel::onSourceRowsRemoved);
+    connect(&m_source, &QAbstractItemModel::modelAboutToBeReset,
+            this, [this]() {
+        m_visibleFirst = m_visibleLast = -1;
+        beginResetModel();
+    });
+    connect(&m_source, &QAbstractItemModel::modelReset,
+            this, [this]() {
+        onSourceReset();
+        endResetModel();
     });
 
-    // Forward model changes from source
+    // Forward model changes from source, new rows are already in place
     connect(&m_source, &PhotoModel::modelChanged, this, &GalleryModel::modelChanged);
-    connect(&m_source, &PhotoModel::modelChanged, this, &GalleryModel::sort);
 
     connect(&m_source, &PhotoModel::loadingStarted, this, [this](const QList<int> &roles) {
         if(!roles.isEmpty() && !roles.contains(m_sortMode)) return;
@@ -45,10 +62,437 @@ GalleryModel::GalleryModel(AppSettings *settings, PhotoModel& sourceModel, QObje
     });
     connect(&m_source, &PhotoModel::loadingFinished, this, &GalleryModel::loadingFinished);
 
-    connect(this, &QSortFilterProxyModel::layoutChanged, this, &GalleryModel::modelChanged);
-    connect(this, &QSortFilterProxyModel::modelReset, this, &GalleryModel::modelChanged);
+    connect(this, &QAbstractItemModel::layoutChanged, this, &GalleryModel::modelChanged);
+    connect(this, &QAbstractItemModel::modelReset, this, &GalleryModel::modelChanged);
+}
+
+
+//----- QAbstractListModel override -----//
+int GalleryModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid()) return 0;
+    return int(m_proxyToSource.size());
+}
+
+QVariant GalleryModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid()) return {};
+    const int sourceRow = mapToSource(index.row());
+    if (sourceRow < 0) return {};
+    return m_source.data(m_source.index(sourceRow), role);
+}
+
+QHash<int, QByteArray> GalleryModel::roleNames() const {
+    return m_source.roleNames();
+}
+
+
+//----- Row mapping -----//
+void GalleryModel::rebuildInverse() {
+    m_sourceToProxy.assign(m_source.rowCount(), NotMapped);
+    for (size_t row = 0; row < m_proxyToSource.size(); ++row)
+        m_sourceToProxy[m_proxyToSource[row]] = uint32_t(row);
+}
+
+bool GalleryModel::clampRange(int &firstRow, int &lastRow) const {
+    if (firstRow > lastRow) std::swap(firstRow, lastRow);
+    firstRow = std::max(firstRow, 0);
+    lastRow = std::min(lastRow, rowCount() - 1);
+    return firstRow <= lastRow;
+}
+
+std::vector<uint32_t> GalleryModel::sourceRows(int firstRow, int lastRow) const {
+    if (!clampRange(firstRow, lastRow)) return {};
+    return std::vector<uint32_t>(m_proxyToSource.begin() + firstRow, m_proxyToSource.begin() + lastRow + 1);
+}
+
+void GalleryModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+    const int firstSourceRow = topLeft.row();
+    const int lastSourceRow = bottomRight.row();
+    const bool facetsChanged = roles.isEmpty() || std::any_of(roles.cbegin(), roles.cend(), [this](int role) { return isFacetRole(role); });
+    const bool sortChanged = roles.isEmpty() || roles.contains(m_sortMode);
+    if (facetsChanged) updateFacets(firstSourceRow, lastSourceRow);
+    if (roles.isEmpty() || roles.contains(PhotoModel::DateRole))
+        updateDayKeys(firstSourceRow, lastSourceRow);
+    if (sortChanged)
+        updateSortKeys(firstSourceRow, lastSourceRow);
+
+    // Under a filter only the changed rows are tested again, the ones that flip enter or leave the view
+    std::vector<uint32_t> entering;
+    if (facetsChanged && m_filter.isActive()) {
+        ensureFacets();
+        std::vector<int> leaving;
+        for (int sourceRow = firstSourceRow; sourceRow <= lastSourceRow; ++sourceRow) {
+            const bool matches = m_facets.matches(m_filter, sourceRow);
+            const int row = mapFromSource(sourceRow);
+            if (matches && row < 0) entering.push_back(uint32_t(sourceRow));
+            else if (!matches && row >= 0) leaving.push_back(row);
+        }
+        if (!leaving.empty()) {
+            removeViewRows(leaving);
+            rebuildInverse();
+            rebuildTimeline();
+        }
+    }
+
+    // Only the changed rows move, the rest of the view is sorted already
+    if (sortChanged) {
+        std::vector<uint32_t> rows;
+        for (int sourceRow = firstSourceRow; sourceRow <= lastSourceRow; ++sourceRow)
+            if (mapFromSource(sourceRow) >= 0) rows.push_back(uint32_t(sourceRow));
+        if (!rows.empty()) changeLayout([this, &rows]() { placeRows(rows); });
+    }
+    if (!entering.empty()) insertSourceRows(entering);
+    if (sortChanged) return;
+
+    // Changed source ranges scatter over the view, emit their proxy bounds once
+    int first = rowCount();
+    int last = -1;
+    for (int sourceRow = firstSourceRow; sourceRow <= lastSourceRow; ++sourceRow) {
+        const int row = mapFromSource(sourceRow);
+        if (row < 0) continue;
+        first = std::min(first, row);
+        last = std::max(last, row);
+    }
+    if (first <= last)
+        emit dataChanged(index(first), index(last), roles);
+}
+
+void GalleryModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last) {
+    if (parent.isValid()) return;
+    const uint32_t count = uint32_t(last - first + 1);
+    const bool append = first >= int(m_sourceToProxy.size());
+    m_dayKeys.insert(m_dayKeys.begin() + std::min<size_t>(first, m_dayKeys.size()), count, 0);
+    updateDayKeys(first, last);
+    m_sortKeys.insertRows(std::min(first, m_sortKeys.rowCount()), int(count));
+    updateSortKeys(first, last);
+
+    // Shift existing mappings behind the insertion point
+    if (!append) {
+        m_facetsDirty = true;
+        for (uint32_t &sourceRow : m_proxyToSource)
+            if (sourceRow >= uint32_t(first)) sourceRow += count;
+    }
+    rebuildInverse();
+
+    // Appended rows extend the facets, under an active filter only the matching ones show up
+    std::vector<uint32_t> added;
+    added.reserve(count);
+    if (m_filter.isActive()) {
+        if (append) updateFacets(first, last);
+        ensureFacets();
+        for (int sourceRow = first; sourceRow <= last; ++sourceRow)
+            if (m_facets.matches(m_filter, sourceRow)) added.push_back(uint32_t(sourceRow));
+    }
+    else {
+        m_facetsDirty = true;
+        for (int sourceRow = first; sourceRow <= last; ++sourceRow)
+            added.push_back(uint32_t(sourceRow));
+    }
+    if (!added.empty()) insertSourceRows(added);
+}
+
+void GalleryModel::insertSourceRows(std::vector<uint32_t> &rows) {
+    // New rows go straight to their sorted positions: sorting them and a binary search per row
+    // instead of sorting the whole view again
+    const auto before = [this](uint32_t l, uint32_t r) { return sortsBefore(l, r); };
+    std::stable_sort(rows.begin(), rows.end(), before);
+    std::vector<size_t> positions(rows.size());
+    size_t runs = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        positions[i] = size_t(std::upper_bound(m_proxyToSource.begin(), m_proxyToSource.end(), rows[i], before) - m_proxyToSource.begin());
+        if (i == 0 || positions[i] != positions[i - 1]) ++runs;
+    }
+
+    if (runs <= MaxInsertRuns) {
+        // Runs that share an insertion point, from the back so positions in front stay valid
+        m_proxyToSource.reserve(m_proxyToSource.size() + rows.size());
+        for (size_t end = rows.size(); end > 0;) {
+            size_t begin = end - 1;
+            while (begin > 0 && positions[begin - 1] == positions[begin]) --begin;
+            const int row = int(positions[begin]);
+            beginInsertRows(QModelIndex(), row, row + int(end - begin) - 1);
+            m_proxyToSource.insert(m_proxyToSource.begin() + row, rows.begin() + begin, rows.begin() + end);
+            endInsertRows();
+            end = begin;
+        }
+        rebuildInverse();
+        rebuildTimeline();
+    }
+    else {
+        // Scattered over the view, appended first and merged in with one layout change
+        const int row = rowCount();
+        beginInsertRows(QModelIndex(), row, row + int(rows.size()) - 1);
+        m_proxyToSource.insert(m_proxyToSource.end(), rows.begin(), rows.end());
+        rebuildInverse();
+        endInsertRows();
+        changeLayout([this, &rows]() { placeRows(rows); });
+    }
+    m_sortSettled = false;
+}
+
+void GalleryModel::onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last) {
+    if (parent.isValid()) return;
+
+    std::vector<int> rows;
+    for (int sourceRow = first; sourceRow <= last; ++sourceRow) {
+        const int row = mapFromSource(sourceRow);
+        if (row >= 0) rows.push_back(row);
+    }
+    removeViewRows(rows);
+}
+
+void GalleryModel::removeViewRows(std::vector<int> &rows) {
+    // Rows scatter over the view, remove them in runs from the back
+    std::sort(rows.begin(), rows.end());
+    for (size_t end = rows.size(); end > 0;) {
+        size_t begin = end - 1;
+        while (begin > 0 && rows[begin - 1] == rows[begin] - 1) --begin;
+        beginRemoveRows(QModelIndex(), rows[begin], rows[end - 1]);
+        m_proxyToSource.erase(m_proxyToSource.begin() + rows[begin], m_proxyToSource.begin() + rows[end - 1] + 1);
+        endRemoveRows();
+        end = begin;
+    }
+}
+
+void GalleryModel::onSourceRowsRemoved(const QModelIndex &parent, int first, int last) {
+    if (parent.isValid()) return;
+    m_facetsDirty = true;
+    const uint32_t count = uint32_t(last - first + 1);
+
+    // Shift remaining mappings behind the removed range
+    for (uint32_t &sourceRow : m_proxyToSource)
+        if (sourceRow > uint32_t(last)) sourceRow -= count;
+
+    const size_t end = std::min<size_t>(size_t(last) + 1, m_dayKeys.size());
+    if (size_t(first) < end) m_dayKeys.erase(m_dayKeys.begin() + first, m_dayKeys.begin() + end);
+    if (first < m_sortKeys.rowCount()) m_sortKeys.removeRows(first, std::min(last + 1, m_sortKeys.rowCount()) - first);
+
+    rebuildInverse();
+    rebuildTimeline();
+    emit modelChanged(); // rows moved into view need their thumbnails
+}
+
+void GalleryModel::onSourceReset() {
+    m_facetsDirty = true;
+    m_dayKeys.assign(m_source.rowCount(), 0);
+    updateDayKeys(0, m_source.rowCount() - 1);
+    rebuildSortKeys();
+    rebuildRows();
+    rebuildTimeline();
+}
+
+void GalleryModel::rebuildRows() {
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::rebuildRows");
+    Metrics::GuiScope guiTime;
+    if (!m_filter.isActive()) {
+        m_proxyToSource.resize(m_source.rowCount());
+        std::iota(m_proxyToSource.begin(), m_proxyToSource.end(), 0u);
+    }
+    else {
+        ensureFacets();
+        const FacetIndex::Bitmap matches = m_facets.evaluate(m_filter);
+        m_proxyToSource.clear();
+        for (int row = 0; row < m_facets.rowCount(); ++row)
+            if (FacetIndex::test(matches, row)) m_proxyToSource.push_back(uint32_t(row));
+    }
+    rebuildInverse();
+}
+
+bool GalleryModel::sortsBefore(uint32_t leftSourceRow, uint32_t rightSourceRow) const {
+    // Descending order swaps the arguments, same as QSortFilterProxyModel
+    return m_sortAscending ? lessThan(int(leftSourceRow), int(rightSourceRow)) : lessThan(int(rightSourceRow), int(leftSourceRow));
+}
+
+void GalleryModel::sortRows() {
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::sortRows");
+    std::stable_sort(m_proxyToSource.begin(), m_proxyToSource.end(), [this](uint32_t l, uint32_t r) { return sortsBefore(l, r); });
+    m_sortSettled = true;
+    rebuildInverse();
+    rebuildTimeline();
+}
+
+void GalleryModel::placeRows(std::vector<uint32_t> &rows) {
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::placeRows");
+    const auto before = [this](uint32_t l, uint32_t r) { return sortsBefore(l, r); };
+
+    // Take the rows out, what remains keeps its order
+    std::vector<bool> moved(m_sourceToProxy.size(), false);
+    for (uint32_t row : rows)
+        moved[row] = true;
+    m_proxyToSource.erase(std::remove_if(m_proxyToSource.begin(), m_proxyToSource.end(), [&moved](uint32_t row) { return moved[row]; }),
+                          m_proxyToSource.end());
+
+    // Sorted among themselves and merged back in
+    std::stable_sort(rows.begin(), rows.end(), before);
+    const size_t middle = m_proxyToSource.size();
+    m_proxyToSource.insert(m_proxyToSource.end(), rows.begin(), rows.end());
+    std::inplace_merge(m_proxyToSource.begin(), m_proxyToSource.begin() + middle, m_proxyToSource.end(), before);
+    m_sortSettled = false;
+    rebuildInverse();
+    rebuildTimeline();
+}
+
+void GalleryModel::changeLayout(const std::function<void()> &reorder) {
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // Remember persistent indexes by source row to restore them after reordering
+    const QModelIndexList fromIndexes = persistentIndexList();
+    std::vector<int> persistentSourceRows;
+    persistentSourceRows.reserve(fromIndexes.size());
+    for (const QModelIndex &idx : fromIndexes)
+        persistentSourceRows.push_back(mapToSource(idx.row()));
+
+    reorder();
+
+    QModelIndexList toIndexes;
+    toIndexes.reserve(fromIndexes.size());
+    for (int sourceRow : persistentSourceRows)
+        toIndexes.append(mapFromSource(sourceRow) >= 0 ? index(mapFromSource(sourceRow)) : QModelIndex());
+    changePersistentIndexList(fromIndexes, toIndexes);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void GalleryModel::sort() {
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::sort");
+    Metrics::GuiScope guiTime;
+    changeLayout([this]() { sortRows(); });
+}
+
+void GalleryModel::settleSort() {
+    if (!m_sortSettled) sort();
+}
+
+
+
+//----- Faceted filtering -----//
+bool GalleryModel::isFacetRole(int role) const {
+    return role == PhotoModel::CameraModelRole || role == PhotoModel::LensModelRole || role == PhotoModel::IsoRole
+        || role == PhotoModel::DateRole || role == PhotoModel::FocalLengthRole;
+}
+
+void GalleryModel::ensureFacets() {
+    if (!m_facetsDirty) return;
+
+    const int count = m_source.rowCount();
+    m_facets.clear();
+    m_facets.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        const ExifData exif = m_source.exifData(row);
+        const QDateTime date = m_source.photoDate(row, exif);
+        m_facets.addRow(exif.cameraModel, exif.lensModel, exif.iso,
+                        date.isValid() ? date.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min(),
+                        exif.focalLength.value);
+    }
+    m_facets.finalize();
+    m_facetsDirty = false;
+}
+
+void GalleryModel::updateFacets(int firstSourceRow, int lastSourceRow) {
+    // Kept current row by row while a filter needs it, otherwise rebuilt once it is asked for
+    if (m_facetsDirty || !m_filter.isActive() || firstSourceRow > m_facets.rowCount()) {
+        m_facetsDirty = true;
+        return;
+    }
+
+    lastSourceRow = std::min(lastSourceRow, m_source.rowCount() - 1);
+    for (int row = firstSourceRow; row <= lastSourceRow; ++row) {
+        const ExifData exif = m_source.exifData(row);
+        const QDateTime date = m_source.photoDate(row, exif);
+        m_facets.setRow(row, exif.cameraModel, exif.lensModel, exif.iso,
+                        date.isValid() ? date.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min(),
+                        exif.focalLength.value);
+    }
+    m_facets.commit();
+}
+
+void GalleryModel::applyFilter() {
+    m_visibleFirst = m_visibleLast = -1; // other photos come into view
+    beginResetModel();
+    rebuildRows();
+    sortRows();
+    endResetModel();
+}
+
+void GalleryModel::setFilter(const QVariantMap &filter) {
+    FacetIndex::Filter f;
+    f.cameraModels = filter.value("cameraModels").toStringList();
+    f.lensModels = filter.value("lensModels").toStringList();
+    if (filter.contains("isoMin")) f.isoMin = filter.value("isoMin").toInt();
+    if (filter.contains("isoMax")) f.isoMax = filter.value("isoMax").toInt();
+    if (filter.contains("dateFrom")) f.dateFrom = filter.value("dateFrom").toDateTime().toMSecsSinceEpoch();
+    if (filter.contains("dateTo")) f.dateTo = filter.value("dateTo").toDateTime().toMSecsSinceEpoch();
+    if (filter.contains("focalLengthMin")) f.focalLengthMin = filter.value("focalLengthMin").toDouble();
+    if (filter.contains("focalLengthMax")) f.focalLengthMax = filter.value("focalLengthMax").toDouble();
+
+    m_filter = f;
+    applyFilter();
+    emit filterChanged();
+}
+
+void GalleryModel::clearFilter() {
+    if (!m_filter.isActive()) return;
+    setFilter({});
 }
 
+QStringList GalleryModel::cameraModels() {
+    ensureFacets();
+    QStringList values = m_facets.cameraModels();
+    values.removeAll(QString());
+    values.sort(Qt::CaseInsensitive);
+    return values;
+}
+
+QStringList GalleryModel::lensModels() {
+    ensureFacets();
+    QStringList values = m_facets.lensModels();
+    values.removeAll(QString());
+    values.sort(Qt::CaseInsensitive);
+    return values;
+}
+
+
+//----- Date timeline -----//
+void GalleryModel::updateDayKeys(int firstSourceRow, int lastSourceRow) {
+    firstSourceRow = std::max(firstSourceRow, 0);
+    lastSourceRow = std::min(lastSourceRow, int(m_dayKeys.size()) - 1);
+    for (int row = firstSourceRow; row <= lastSourceRow; ++row)
+        m_dayKeys[row] = TimelineIndex::dayKey(m_source.data(m_source.index(row), PhotoModel::DateRole).toDate());
+}
+
+void GalleryModel::rebuildTimeline() {
+    // Buckets are only contiguous when sorted by date
+    if (m_sortMode == PhotoModel::DateRole) m_timeline.rebuild(m_proxyToSource, m_dayKeys);
+    else m_timeline.clear();
+    emit timelineChanged();
+}
+
+QVariantList GalleryModel::timeline() const {
+    QVariantList list;
+    for (const TimelineIndex::Bucket &bucket : m_timeline.buckets(TimelineIndex::Month)) {
+        QVariantMap map;
+        map["year"] = bucket.key / 100;
+        map["month"] = bucket.key % 100;
+        map["firstRow"] = bucket.firstRow;
+        map["count"] = bucket.count;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantMap GalleryModel::timelineBucketAt(int row) const {
+    const int bucket = m_timeline.bucketAt(TimelineIndex::Month, row);
+    if (bucket < 0) return {};
+    const TimelineIndex::Bucket &month = m_timeline.buckets(TimelineIndex::Month)[bucket];
+    QVariantMap map;
+    map["year"] = month.key / 100;
+    map["month"] = month.key % 100;
+    map["firstRow"] = month.firstRow;
+    map["count"] = month.count;
+    return map;
+}
+
+
+//----- Settings -----//
 void GalleryModel::onSettingChanged(const QString &id, const QVariant &value) {
     if(id == QStringLiteral("gallerySortMode")) {
         setSortMode(value.toString());
@@ -59,8 +503,8 @@ void GalleryModel::onSettingChanged(const QString &id, const QVariant &value) {
 }
 
 void GalleryModel::loadSettings() {
-    setSortMode(m_settings->getValue("gallerySortMode").toString());
-    setSortAscending(m_settings->getValue("gallerySortAscending").toBool());
+    setSortMode(m_settings->value<QString>("gallerySortMode"));
+    setSortAscending(m_settings->value<bool>("gallerySortAscending"));
 }
 
 void GalleryModel::setSortAscending(bool asc) {
@@ -73,6 +517,7 @@ void GalleryModel::setSortAscending(bool asc) {
 
 QHash<QString, int> GalleryModel::sortRoles() const {
     return {
+        { "name", PhotoModel::FilePathRole },
         { "size", PhotoModel::FileSizeRole },
         { "date", PhotoModel::DateRole },
         { "exposure", PhotoModel::ExposureTimeRole },
@@ -87,107 +532,112 @@ void GalleryModel::setSortMode(QString mode) {
     if(m_sortMode == role) return;
     m_sortMode = role;
     m_settings->setValue("gallerySortMode", mode);
+    rebuildSortKeys();
     sort();
 }
 
-bool GalleryModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
-    int dataRole = m_sortMode;
-    const QVariant leftData = m_source.data(left, dataRole);
-    const QVariant rightData = m_source.data(right, dataRole);
+bool GalleryModel::lessThan(int leftSourceRow, int rightSourceRow) const {
+    return m_sortKeys.lessThan(leftSourceRow, rightSourceRow);
+}
+
+void GalleryModel::rebuildSortKeys() {
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::rebuildSortKeys");
+    Metrics::GuiScope guiTime;
+    SortKeyIndex::Kind kind = SortKeyIndex::Number;
+    if (m_sortMode == PhotoModel::FilePathRole) kind = SortKeyIndex::NaturalText;
+    else if (m_sortMode == PhotoModel::CameraModelRole) kind = SortKeyIndex::Text;
+    m_sortKeys.reset(kind, m_source.rowCount());
+    updateSortKeys(0, m_source.rowCount() - 1);
+}
 
-    switch (dataRole) {
-        case PhotoModel::FilePathRole: {
-            const QString l = leftData.toString();
-            const QString r = rightData.toString();
-            const bool less = l.localeAwareCompare(r) < 0;
-            return less;
-        }
-        case PhotoModel::FileSizeRole: {
-            const qint64 l = leftData.toLongLong();
-            const qint64 r = rightData.toLongLong();
-            return l < r;
-        }
-        case PhotoModel::DateRole: {
-            const QDateTime l = leftData.toDateTime();
-            const QDateTime r = rightData.toDateTime();
-            if(!l.isValid() || !r.isValid()) return false;
-            return l < r;
-        }
-        case PhotoModel::ExposureTimeRole: {
-            const double l = leftData.toDouble();
-            const double r = rightData.toDouble();
-            return l < r;
-        }
-        case PhotoModel::CameraModelRole: {
-            const QString l = leftData.toString();
-            const QString r = rightData.toString();
-            const bool less = l.localeAwareCompare(r) < 0;
-            return less;
-        }
-        case PhotoModel::IsoRole: {
-            const int l = leftData.toInt();
-            const int r = rightData.toInt();
-            return l < r;
-        }
-        case PhotoModel::FocalLengthRole: {
-            const double l = leftData.toDouble();
-            const double r = rightData.toDouble();
-            return l < r;
+void GalleryModel::updateSortKeys(int firstSourceRow, int lastSourceRow) {
+    firstSourceRow = std::max(firstSourceRow, 0);
+    lastSourceRow = std::min(lastSourceRow, m_sortKeys.rowCount() - 1);
+
+    // Role data is fetched once per changed row here, never per comparison
+    for (int row = firstSourceRow; row <= lastSourceRow; ++row) {
+        const QVariant value = m_source.data(m_source.index(row), m_sortMode);
+        switch (m_sortMode) {
+            case PhotoModel::FilePathRole:
+            case PhotoModel::CameraModelRole:
+                m_sortKeys.setText(row, value.toString());
+                break;
+            case PhotoModel::FileSizeRole:
+                m_sortKeys.setNumber(row, double(value.toLongLong()));
+                break;
+            case PhotoModel::DateRole: {
+                // Photos without a date go behind the dated ones
+                const QDateTime date = value.toDateTime();
+                m_sortKeys.setNumber(row, date.isValid() ? double(date.toMSecsSinceEpoch()) : std::numeric_limits<double>::infinity());
+                break;
+            }
+            default:
+                m_sortKeys.setNumber(row, value.toDouble());
         }
-        default:
-            return false;
     }
+    m_sortKeys.updateRanks();
 }
 
 void GalleryModel::loadThumbnails(int firstIndex, int lastIndex, int itemsPerRow, int preloadDirection) {
     if (firstIndex < 0 || lastIndex < 0) return;
+    LYSA_TRACE_SCOPE("gallery", "GalleryModel::loadThumbnails");
+    Metrics::GuiScope guiTime;
+    if (m_scrollRecorder) m_scrollRecorder->record(firstIndex, lastIndex, itemsPerRow, preloadDirection);
+
+    // Hit rate counts rows as they come into view, not on every scroll step they stay visible.
+    // A single row is a preload of the photo view, not the visible range.
+    int first = firstIndex, last = lastIndex;
+    if (firstIndex != lastIndex && clampRange(first, last)) {
+        for (int i = first; i <= last; ++i)
+            if (i < m_visibleFirst || i > m_visibleLast) m_source.recordThumbnailLookup(int(m_proxyToSource[i]));
+        m_visibleFirst = firstIndex;
+        m_visibleLast = lastIndex;
+    }
 
     // Ensure visible ones are loaded
-    _loadThumbnails(firstIndex, lastIndex);
+    _loadThumbnails(firstIndex, lastIndex, true);
 
-    // Preload adjacent rows (if preloadDirection = 0: both directions)
-    int preloadRows = 5;
-    if(preloadDirection >= 0) _loadThumbnails(lastIndex + 1, lastIndex + itemsPerRow * preloadRows);
-    if(preloadDirection <= 0) _loadThumbnails(firstIndex - 1, firstIndex - itemsPerRow * preloadRows);
+    // Preload whole rows with a third of what the budget leaves after the visible ones,
+    // capped at two screens (if preloadDirection = 0: split over both directions)
+    itemsPerRow = std::max(itemsPerRow, 1);
+    const int visibleCount = lastIndex - firstIndex + 1;
+    const int spare = std::max(0, m_source.thumbnailCapacity() - visibleCount);
+    int preloadRows = std::min(spare / 3, visibleCount * 2) / itemsPerRow;
+    if(preloadDirection == 0) preloadRows /= 2;
+    const int preloadCount = preloadRows * itemsPerRow;
+    if(preloadCount > 0 && preloadDirection >= 0) _loadThumbnails(lastIndex + 1, lastIndex + preloadCount);
+    if(preloadCount > 0 && preloadDirection <= 0) _loadThumbnails(firstIndex - preloadCount, firstIndex - 1);
 
     if(firstIndex - lastIndex == 0) return; //Don't delete old if only singular preload
-    int cacheRowsDistance = 30;
-    clearOldThumbnails(firstIndex - itemsPerRow * preloadRows, lastIndex + itemsPerRow * preloadRows, cacheRowsDistance * preloadRows);
-}
-
-void GalleryModel::_loadThumbnails(int firstIndex, int lastIndex) {
-    for (int i = firstIndex; i <= lastIndex; ++i) {
-        QModelIndex sourceIndex = mapToSource(index(i, 0));
-        m_source.loadThumbnail(sourceIndex.row());
-    }
+    clearOldThumbnails(firstIndex - preloadCount, lastIndex + preloadCount);
 }
 
-void GalleryModel::clearOldThumbnails(int firstPreloaded, int lastPreloaded, int maxCacheDistance) {
-    _clearThumbnails(0, firstPreloaded - 1 - maxCacheDistance);
-    _clearThumbnails(lastPreloaded + 1 + maxCacheDistance, m_source.rowCount() - 1);
+void GalleryModel::_loadThumbnails(int firstIndex, int lastIndex, bool visible) {
+    if (!clampRange(firstIndex, lastIndex)) return;
+    for (int i = firstIndex; i <= lastIndex; ++i)
+        m_source.loadThumbnail(int(m_proxyToSource[i]), visible);
 }
 
-void GalleryModel::_clearThumbnails(int from, int to) {
-    for(int i = from; i <= to; ++i) {
-        QModelIndex sourceIndex = mapToSource(index(i, 0));
-        m_source.clearThumbnail(sourceIndex.row());
+void GalleryModel::clearOldThumbnails(int firstPreloaded, int lastPreloaded) {
+    // Evict least recently used thumbnails outside the preloaded window until the byte budget fits,
+    // only resident thumbnails are visited instead of sweeping the whole album
+    int sourceRow = m_source.leastRecentThumbnail();
+    while (sourceRow >= 0 && m_source.thumbnailsOverBudget()) {
+        const int next = m_source.moreRecentThumbnail(sourceRow);
+        const int row = mapFromSource(sourceRow);
+        if (row < 0 || row < firstPreloaded || row > lastPreloaded) m_source.clearThumbnail(sourceRow); // -1: filtered out
+        sourceRow = next;
     }
 }
 
 int GalleryModel::getIndex(QString filePath) {
-    int sourceIndex = m_source.getIndex(filePath);
-    if (sourceIndex < 0) return -1;
-
-    QModelIndex sourceIdx = m_source.index(sourceIndex, 0);
-    QModelIndex proxyIdx = mapFromSource(sourceIdx);
-    return proxyIdx.row();
+    return mapFromSource(m_source.getIndex(filePath));
 }
 
 PhotoProvider* GalleryModel::getProvider(int idx) {
     if (idx < 0 || idx >= rowCount()) return nullptr;
     // Requested provider (active)
-    QModelIndex sourceIdx = mapToSource(index(idx, 0));
-    PhotoProvider* provider = m_source.getProvider(sourceIdx.row(), idx);
+    PhotoProvider* provider = m_source.getProvider(mapToSource(idx));
     if(provider) provider->setActive(true);
 
     // Preload neighbors (not active)
@@ -196,13 +646,20 @@ PhotoProvider* GalleryModel::getProvider(int idx) {
         if(i == idx) continue; //Already loaded (active)
         if(i < 0) continue;
         if(i >= rowCount()) break;
-        QModelIndex sourceI = mapToSource(index(i, 0));
-        PhotoProvider* preload = m_source.getProvider(sourceI.row(), i);
+        PhotoProvider* preload = m_source.getProvider(mapToSource(i));
         if(preload) preload->setActive(false);
     }
 
-    // Prune all providers that are not needed to free-up memory
-    m_source.pruneProviders();
+    // Prune all providers that are not needed to free-up memory. Providers are kept by source row,
+    // neighbours are those of the current order, so a resort or removal cannot hand out a wrong photo.
+    QSet<int> keep;
+    for (int row : m_source.activeProviders()) {
+        const int viewIndex = mapFromSource(row);
+        if (viewIndex < 0) continue;
+        for (int i = qMax(0, viewIndex - providerPreloadDistance); i <= qMin(rowCount() - 1, viewIndex + providerPreloadDistance); ++i)
+            keep << mapToSource(i);
+    }
+    m_source.pruneProviders(keep);
 
     return provider;
 }
@@ -19,16 +19,36 @@
 #pragma once
 #include "photomodel.h"
 #include "photoprovider.h"
-#include <QSortFilterProxyModel>
+#include "facetindex.h"
+#include "timelineindex.h"
+#include "sortkeyindex.h"
+#include "scrolltrace.h"
+#include <QAbstractListModel>
+#include <functional>
+#include <vector>
+#include <cstdint>
 
-class GalleryModel : public QSortFilterProxyModel {
+// Sorted view onto PhotoModel, backed by plain forward/inverse row permutations
+class GalleryModel : public QAbstractListModel {
     Q_OBJECT
     Q_PROPERTY(bool sortAscending READ sortAscending WRITE setSortAscending NOTIFY sortAscendingChanged)
+    Q_PROPERTY(bool filterActive READ filterActive NOTIFY filterChanged)
+    Q_PROPERTY(QVariantList timeline READ timeline NOTIFY timelineChanged)
 
 public:
     explicit GalleryModel(AppSettings *settings, PhotoModel& sourceModel, QObject *parent = nullptr);
 
-    void sort() { QSortFilterProxyModel::sort(0, m_sortAscending ? Qt::AscendingOrder : Qt::DescendingOrder); }
+    void sort();
+    void settleSort(); // full sort once rows stopped streaming in, if any were placed since the last one
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // O(1) row mapping, -1 if out of range
+    int mapToSource(int row) const { return row >= 0 && row < int(m_proxyToSource.size()) ? int(m_proxyToSource[row]) : -1; }
+    int mapFromSource(int sourceRow) const { return sourceRow >= 0 && sourceRow < int(m_sourceToProxy.size()) && m_sourceToProxy[sourceRow] != NotMapped ? int(m_sourceToProxy[sourceRow]) : -1; }
+    std::vector<uint32_t> sourceRows(int firstRow, int lastRow) const;
 
     void onSettingChanged(const QString &id, const QVariant &value);
     void loadSettings();
@@ -41,25 +61,87 @@ public:
 
     Q_INVOKABLE int size() { return m_source.rowCount(); }
 
+    // Faceted filtering, keys: cameraModels, lensModels, isoMin/isoMax, dateFrom/dateTo, focalLengthMin/focalLengthMax
+    bool filterActive() const { return m_filter.isActive(); }
+    Q_INVOKABLE void setFilter(const QVariantMap &filter);
+    Q_INVOKABLE void clearFilter();
+    Q_INVOKABLE QStringList cameraModels();
+    Q_INVOKABLE QStringList lensModels();
+
+    // Date timeline (month buckets with their first row), only available under date sort
+    QVariantList timeline() const;
+    Q_INVOKABLE int rowForDate(int year, int month = 0, int day = 0) const { return m_timeline.firstRow(year, month, day); }
+    Q_INVOKABLE QVariantMap timelineBucketAt(int row) const;
+
     Q_INVOKABLE void loadThumbnails(int firstIndex, int lastIndex, int itemsPerRow, int preloadDirection);
-    void _loadThumbnails(int firstIndex, int lastIndex);
-    void clearOldThumbnails(int firstPreloaded, int lastPreloaded, int maxCacheDistance);
-    void _clearThumbnails(int from, int to);
+    void _loadThumbnails(int firstIndex, int lastIndex, bool visible = false);
+    void clearOldThumbnails(int firstPreloaded, int lastPreloaded);
+    void setScrollRecorder(ScrollTrace *trace) { m_scrollRecorder = trace; } // records every loadThumbnails() request
+    Q_INVOKABLE QVariantMap thumbnailMetrics() const { return m_source.thumbnailMetrics(); }
+    Q_INVOKABLE QVariantMap memoryMetrics() const { return m_source.memoryMetrics(); }
     Q_INVOKABLE int getIndex(QString filePath);
     Q_INVOKABLE PhotoProvider* getProvider(int index);
 
 signals:
     void sortAscendingChanged();
+    void filterChanged();
+    void timelineChanged();
     void modelChanged();
     void loadingStarted();
     void loadingFinished();
 
 protected:
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    bool lessThan(int leftSourceRow, int rightSourceRow) const;
 
 private:
     AppSettings* m_settings;
     PhotoModel& m_source;
     bool m_sortAscending = true;
-    int m_sortMode;
+    int m_sortMode = -1;
+
+    static constexpr uint32_t NotMapped = UINT32_MAX; // filtered out source rows
+
+    std::vector<uint32_t> m_proxyToSource;
+    std::vector<uint32_t> m_sourceToProxy;
+    void rebuildRows();
+    void rebuildInverse();
+    void sortRows();
+    bool sortsBefore(uint32_t leftSourceRow, uint32_t rightSourceRow) const; // in view order
+
+    // Rows that arrive or change while the view is sorted are placed by a merge instead of a full sort
+    static constexpr size_t MaxInsertRuns = 32; // more insertion points are merged with one layout change
+    bool m_sortSettled = true;
+    void placeRows(std::vector<uint32_t> &rows); // source rows in the view, sorted and merged back in
+    void insertSourceRows(std::vector<uint32_t> &rows); // source rows not in the view yet
+    void removeViewRows(std::vector<int> &rows);
+    void changeLayout(const std::function<void()> &reorder); // keeps persistent indexes on their source rows
+    bool clampRange(int &firstRow, int &lastRow) const;
+
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceReset();
+
+    FacetIndex m_facets;
+    FacetIndex::Filter m_filter;
+    bool m_facetsDirty = true;
+    bool isFacetRole(int role) const;
+    void ensureFacets();
+    void updateFacets(int firstSourceRow, int lastSourceRow);
+    void applyFilter();
+
+    TimelineIndex m_timeline;
+    std::vector<int32_t> m_dayKeys; // per source row, kept in sync as dates arrive
+    void updateDayKeys(int firstSourceRow, int lastSourceRow);
+    void rebuildTimeline();
+
+    // Sort key per source row, kept in sync as rows and metadata arrive
+    SortKeyIndex m_sortKeys;
+    void rebuildSortKeys();
+    void updateSortKeys(int firstSourceRow, int lastSourceRow);
+
+    ScrollTrace *m_scrollRecorder = nullptr;
+    int m_visibleFirst = -1; // view rows of the previous loadThumbnails(), only rows entering them count as lookups
+    int m_visibleLast = -1;
 };
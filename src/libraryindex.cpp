@@ -0,0 +1,258 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "libraryindex.h"
+#include <QSet>
+#include <algorithm>
+
+void LibraryIndex::clear() {
+    m_directories.clear();
+    m_lookup.clear();
+    m_complete = false;
+}
+
+bool LibraryIndex::Changes::isEmpty() const {
+    return addedPhotos.isEmpty() && removedPhotos.isEmpty() && modifiedPhotos.isEmpty()
+        && addedDirectories.isEmpty() && removedDirectories.isEmpty();
+}
+
+int LibraryIndex::addDirectory(const WalkedDirectory &walked) {
+    int id = find(walked.path);
+    if (id < 0) {
+        // Only the root is new, every other directory was announced by its parent
+        if (!m_directories.empty()) return -1;
+        id = announce(-1, walked.path);
+    }
+
+    // Reported twice when a subtree scan overlaps the initial one
+    Directory &directory = m_directories[id];
+    addTotals(id, int(walked.files.size()) - int(directory.files.size()), walked.bytes - directory.filesBytes);
+    setFiles(id, walked);
+    directory.scanned = true;
+
+    m_directories.reserve(m_directories.size() + walked.directories.size());
+    for (const QString &path : walked.directories)
+        if (find(path) < 0) announce(id, path);
+    return id;
+}
+
+void LibraryIndex::updateDirectory(const WalkedDirectory &listing, Changes &changes) {
+    const int id = find(listing.path);
+    if (id < 0 || !m_directories[id].scanned) return; // the running scan still reports it
+
+    // Files
+    QHash<QString, const WalkedFile*> previous;
+    const QVector<WalkedFile> &files = m_directories[id].files;
+    previous.reserve(files.size());
+    for (const WalkedFile &file : files)
+        previous.insert(file.name, &file);
+
+    for (const WalkedFile &file : listing.files) {
+        const WalkedFile *old = previous.take(file.name);
+        if (!old) changes.addedPhotos << photoFile(listing.path, file);
+        else if (old->size != file.size || old->modified != file.modified) changes.modifiedPhotos << photoFile(listing.path, file);
+    }
+    for (auto it = previous.cbegin(); it != previous.cend(); ++it)
+        changes.removedPhotos << filePath(listing.path, it.key());
+
+    addTotals(id, int(listing.files.size()) - int(files.size()), listing.bytes - m_directories[id].filesBytes);
+    setFiles(id, listing);
+
+    // Subdirectories
+    const QSet<QString> current(listing.directories.cbegin(), listing.directories.cend());
+    const QVector<int> children = m_directories[id].children;
+    for (int child : children) {
+        if (!current.contains(m_directories[child].path))
+            removeDirectory(m_directories[child].path, changes);
+    }
+    for (const QString &path : listing.directories) {
+        if (find(path) >= 0) continue;
+        announce(id, path);
+        changes.addedDirectories << path;
+    }
+}
+
+void LibraryIndex::removeDirectory(const QString &path, Changes &changes) {
+    const int id = find(path);
+    if (id < 0) return;
+
+    const int parent = m_directories[id].parent;
+    addTotals(id, -m_directories[id].photoCount, -m_directories[id].bytes);
+    if (parent >= 0) {
+        m_directories[parent].children.removeOne(id);
+        recomputeDates(parent);
+    }
+    changes.removedDirectories << path;
+
+    std::vector<int> stack { id };
+    while (!stack.empty()) {
+        Directory &directory = m_directories[stack.back()];
+        stack.pop_back();
+        for (const WalkedFile &file : directory.files)
+            changes.removedPhotos << filePath(directory.path, file.name);
+        stack.insert(stack.end(), directory.children.cbegin(), directory.children.cend());
+
+        m_lookup.remove(directory.path);
+        directory = Directory();
+    }
+}
+
+namespace {
+void extendRange(qint64 &first, qint64 &last, qint64 from, qint64 to) {
+    if (from == 0) return;
+    first = first == 0 ? from : std::min(first, from);
+    last = std::max(last, to);
+}
+}
+
+void LibraryIndex::addTotals(int id, int photos, qint64 bytes) {
+    for (int ancestor = id; ancestor >= 0; ancestor = m_directories[ancestor].parent) {
+        Directory &directory = m_directories[ancestor];
+        directory.photoCount += photos;
+        directory.bytes += bytes;
+    }
+}
+
+void LibraryIndex::setFiles(int id, const WalkedDirectory &walked) {
+    Directory &directory = m_directories[id];
+    const qint64 oldFirst = directory.filesFirstDate;
+    const qint64 oldLast = directory.filesLastDate;
+    directory.files = walked.files;
+    directory.filesBytes = walked.bytes;
+    directory.filesFirstDate = walked.firstDate;
+    directory.filesLastDate = walked.lastDate;
+    if (walked.firstDate == oldFirst && walked.lastDate == oldLast) return;
+
+    // A scan only widens ranges, which is a walk up the ancestors. Narrowed ones are recomputed.
+    const bool widened = oldFirst == 0 || (walked.firstDate != 0 && walked.firstDate <= oldFirst && walked.lastDate >= oldLast);
+    if (widened) extendDates(id, walked.firstDate, walked.lastDate);
+    else recomputeDates(id);
+}
+
+void LibraryIndex::extendDates(int id, qint64 first, qint64 last) {
+    if (first == 0) return;
+    for (int ancestor = id; ancestor >= 0; ancestor = m_directories[ancestor].parent) {
+        Directory &directory = m_directories[ancestor];
+        if (directory.firstDate != 0 && directory.firstDate <= first && directory.lastDate >= last) break; // covered from here up
+        extendRange(directory.firstDate, directory.lastDate, first, last);
+    }
+}
+
+void LibraryIndex::recomputeDates(int id) {
+    for (int ancestor = id; ancestor >= 0; ancestor = m_directories[ancestor].parent) {
+        Directory &directory = m_directories[ancestor];
+        qint64 first = directory.filesFirstDate;
+        qint64 last = directory.filesLastDate;
+        for (int child : directory.children)
+            extendRange(first, last, m_directories[child].firstDate, m_directories[child].lastDate);
+        if (ancestor != id && first == directory.firstDate && last == directory.lastDate) break; // unchanged from here up
+        directory.firstDate = first;
+        directory.lastDate = last;
+    }
+}
+
+int LibraryIndex::announce(int parent, const QString &path) {
+    const int id = int(m_directories.size());
+    m_directories.push_back({});
+    m_directories.back().path = path;
+    m_directories.back().parent = parent;
+    if (parent >= 0) {
+        // Children stay sorted by name, directories created later are inserted in place
+        QVector<int> &children = m_directories[parent].children;
+        auto it = std::lower_bound(children.begin(), children.end(), path,
+            [this](int child, const QString &value) { return m_directories[child].path < value; });
+        children.insert(it, id);
+    }
+    m_lookup.insert(path, id);
+    return id;
+}
+
+int LibraryIndex::photoCount(const QString &path) const {
+    const int id = find(path);
+    return id < 0 ? 0 : m_directories[id].photoCount;
+}
+
+qint64 LibraryIndex::bytes(const QString &path) const {
+    const int id = find(path);
+    return id < 0 ? 0 : m_directories[id].bytes;
+}
+
+LibraryIndex::Aggregates LibraryIndex::aggregates(const QString &path) const {
+    const int id = find(path);
+    if (id < 0) return {};
+
+    const Directory &directory = m_directories[id];
+    return { directory.photoCount, directory.bytes, directory.firstDate, directory.lastDate };
+}
+
+QVector<PhotoFile> LibraryIndex::photoFiles(const QString &path) const {
+    const int id = find(path);
+    if (id < 0) return {};
+
+    QVector<PhotoFile> result;
+    result.reserve(m_directories[id].photoCount);
+
+    // Pre-order, the same order the walker reports directories in
+    std::vector<int> stack { id };
+    while (!stack.empty()) {
+        const Directory &directory = m_directories[stack.back()];
+        stack.pop_back();
+        for (const WalkedFile &file : directory.files)
+            result << photoFile(directory.path, file);
+        for (auto it = directory.children.crbegin(); it != directory.children.crend(); ++it)
+            stack.push_back(*it);
+    }
+    return result;
+}
+
+QVector<WalkedDirectory> LibraryIndex::directories() const {
+    QVector<WalkedDirectory> result;
+    if (m_directories.empty() || !m_directories.front().scanned) return result;
+    result.reserve(int(m_directories.size()));
+
+    std::vector<int> stack { 0 };
+    while (!stack.empty()) {
+        const Directory &directory = m_directories[stack.back()];
+        stack.pop_back();
+        if (!directory.scanned) continue;
+
+        WalkedDirectory walked { directory.path, {}, directory.files, directory.filesBytes, directory.filesFirstDate, directory.filesLastDate };
+        walked.directories.reserve(directory.children.size());
+        for (int child : directory.children)
+            walked.directories << m_directories[child].path;
+        result << walked;
+
+        for (auto it = directory.children.crbegin(); it != directory.children.crend(); ++it)
+            stack.push_back(*it);
+    }
+    return result;
+}
+
+QString LibraryIndex::filePath(const QString &directory, const QString &name) {
+    if (directory.endsWith(QLatin1Char('/'))) return directory + name;
+    return directory + QLatin1Char('/') + name;
+}
+
+PhotoFile LibraryIndex::photoFile(const QString &directory, const WalkedFile &file) {
+    return { filePath(directory, file.name), file.size, file.modified, file.created };
+}
+
+bool LibraryIndex::isInside(const QString &path, const QString &album) {
+    if (!path.startsWith(album)) return false;
+    return path.size() == album.size() || album.endsWith(QLatin1Char('/')) || path.at(album.size()) == QLatin1Char('/');
+}
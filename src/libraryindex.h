@@ -0,0 +1,104 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+#include "directorywalker.h"
+#include "structs.h"
+
+// In-memory result of one walk over the library root: the directory tree, the photos of each directory
+// and recursive photo counts. Switching albums is a lookup here instead of a rescan.
+class LibraryIndex {
+public:
+    struct Directory {
+        QString path;
+        int parent = -1;
+        QVector<int> children;     // sorted by name
+        QVector<WalkedFile> files; // sorted by name
+        int photoCount = 0;        // including all subdirectories scanned so far
+        qint64 bytes = 0;          // likewise
+        qint64 firstDate = 0;      // likewise, msecs since epoch (0 without dated photos)
+        qint64 lastDate = 0;
+        bool scanned = false;
+
+        // Of its own files, as the walker summarized them
+        qint64 filesBytes = 0;
+        qint64 filesFirstDate = 0;
+        qint64 filesLastDate = 0;
+    };
+
+    // Per album totals for the directory tree, dates are msecs since epoch (0 without photos)
+    struct Aggregates {
+        int photoCount = 0;
+        qint64 bytes = 0;
+        qint64 firstDate = 0;
+        qint64 lastDate = 0;
+    };
+
+    // Result of re-listing directories after file system changes
+    struct Changes {
+        QVector<PhotoFile> addedPhotos;
+        QStringList removedPhotos;
+        QVector<PhotoFile> modifiedPhotos; // size or modification time changed
+        QStringList addedDirectories;   // announced but not scanned yet
+        QStringList removedDirectories; // roots of removed subtrees
+
+        bool isEmpty() const;
+    };
+
+    void clear();
+
+    // Directories must be added in walker order, parents before their children.
+    // Returns -1 for directories that are not part of the library (anymore).
+    int addDirectory(const WalkedDirectory &walked);
+    void updateDirectory(const WalkedDirectory &listing, Changes &changes);
+    void removeDirectory(const QString &path, Changes &changes);
+    void setComplete(bool complete) { m_complete = complete; }
+    bool isComplete() const { return m_complete; }
+
+    int find(const QString &path) const { return m_lookup.value(path, -1); }
+    const Directory& directory(int id) const { return m_directories[id]; }
+    int photoCount(const QString &path) const;
+    qint64 bytes(const QString &path) const;
+    Aggregates aggregates(const QString &path) const;
+
+    // Photos of an album and its subdirectories, in scan order
+    QVector<PhotoFile> photoFiles(const QString &path) const;
+    // Scanned directories in walker order, adding them to an empty index restores it
+    QVector<WalkedDirectory> directories() const;
+
+    static QString filePath(const QString &directory, const QString &name);
+    static PhotoFile photoFile(const QString &directory, const WalkedFile &file);
+    static bool isInside(const QString &path, const QString &album);
+
+private:
+    std::vector<Directory> m_directories; // removed directories stay behind unreachable
+    QHash<QString, int> m_lookup;
+    bool m_complete = false;
+
+    // Totals and date ranges are kept current up the ancestors as directories change
+    void addTotals(int id, int photos, qint64 bytes);
+    void setFiles(int id, const WalkedDirectory &walked);
+    void extendDates(int id, qint64 first, qint64 last);
+    void recomputeDates(int id);
+    int announce(int parent, const QString &path);
+};
@@ -0,0 +1,106 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "libraryindexer.h"
+#include "photocontroller.h"
+#include "metrics.h"
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTemporaryDir>
+#include <QTimer>
+
+std::atomic<bool> LibraryIndexer::s_stopRequested { false };
+
+LibraryIndexer::LibraryIndexer(AppSettings *settings, QObject *parent) : QObject(parent), m_settings(settings) {}
+
+int LibraryIndexer::run(const QString &root) {
+    QTextStream err(stderr);
+    if (root.isEmpty() || !QDir(root).exists()) {
+        err << "Library folder does not exist: " << root << "\n";
+        return 1;
+    }
+    LYSA_TRACE_SCOPE("indexer", "LibraryIndexer::run");
+
+    // The controller opens the root through settings of its own, so the user's library and album stay as they are.
+    // Thumbnails go to the disk cache, which any later session opening these photos finds them in.
+    QTemporaryDir settingsDir;
+    AppSettings settings(settingsDir.filePath("indexer.ini"));
+    for (const char *id : { "galleryTargetWidth", "thumbnailDiskCache" })
+        settings.setValue(id, m_settings->getValue(id));
+    settings.setValue("rootFolder", QDir::cleanPath(QFileInfo(root).absoluteFilePath()));
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    int result = 0;
+    {
+        PhotoController controller(&settings);
+        PhotoModel *model = controller.photoModel();
+
+        QEventLoop loop;
+        bool scanned = false;
+        const qint64 generatedBefore = Metrics::counter(Metrics::ThumbnailsGenerated);
+        const qint64 cachedBefore = Metrics::counter(Metrics::ThumbnailsCached);
+
+        // Every photo once the walk is complete, cached ones are only looked up
+        connect(&controller, &PhotoController::scanFinished, &loop, [&]() {
+            if (scanned) return;
+            scanned = true;
+            for (int row = 0; row < model->rowCount(); ++row)
+                model->cacheThumbnail(row);
+            err << "Found " << model->rowCount() << " photos\n";
+            err.flush();
+        });
+
+        QTimer progress;
+        connect(&progress, &QTimer::timeout, &loop, [&]() {
+            if (s_stopRequested.load(std::memory_order_relaxed)) {
+                result = 2;
+                loop.quit();
+                return;
+            }
+            if (!scanned) {
+                err << "\rScanning, " << model->rowCount() << " photos so far";
+            }
+            else {
+                const qint64 generated = Metrics::counter(Metrics::ThumbnailsGenerated) - generatedBefore;
+                const qint64 cached = Metrics::counter(Metrics::ThumbnailsCached) - cachedBefore;
+                err << "\rThumbnails " << generated + cached << "/" << model->rowCount() << " (" << cached << " cached)"
+                    << ", metadata tasks queued " << Metrics::queueDepth(Metrics::ExifPool) << "   ";
+                if (Metrics::idle(Metrics::ThumbnailPool) && Metrics::idle(Metrics::ExifPool)) loop.quit();
+            }
+            err.flush();
+        });
+        progress.start(ProgressIntervalMsecs);
+
+        QTimer checkpoint;
+        connect(&checkpoint, &QTimer::timeout, &loop, [&controller]() { controller.saveSnapshot(); });
+        if (m_checkpointMsecs > 0) checkpoint.start(m_checkpointMsecs);
+
+        loop.exec();
+        err << "\n" << (result == 2 ? "Interrupted, writing a checkpoint" : "Writing the library snapshot") << "\n";
+        err.flush();
+    } // the controller writes the snapshot when it goes away
+
+    err << "Done in " << elapsed.elapsed() / 1000 << " s\n";
+    return result;
+}
@@ -0,0 +1,46 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include "appsettings.h"
+
+// Builds the caches of a whole library without a window (lysa --index <root>): walks the root, extracts every
+// photo's metadata and generates every thumbnail on all cores into the disk cache, then writes the session snapshot
+// the application restores when it opens the root. The user's settings are only read. Progress goes to stderr.
+// A checkpoint is written periodically and on interruption, so another run resumes with the restored snapshot
+// and only generates the thumbnails that are not cached yet.
+class LibraryIndexer : public QObject {
+    Q_OBJECT
+public:
+    explicit LibraryIndexer(AppSettings *settings, QObject *parent = nullptr);
+
+    void setCheckpointInterval(int msecs) { m_checkpointMsecs = msecs; }
+    int run(const QString &root); // exit code: 0 complete, 1 failed, 2 interrupted
+
+    static void requestStop() { s_stopRequested.store(true, std::memory_order_relaxed); } // safe from signal handlers
+
+private:
+    static constexpr int ProgressIntervalMsecs = 1000;
+
+    AppSettings *m_settings; // the user's, for the thumbnail resolution and cache size
+    int m_checkpointMsecs = 10 * 60 * 1000;
+    static std::atomic<bool> s_stopRequested;
+};
@@ -0,0 +1,159 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "librarysnapshot.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace {
+const quint32 Magic = 0x4C59534E; // "LYSN"
+const quint32 Version = 2; // 1 was a single library.snapshot with copies of the album's thumbnails
+
+void writeRational(QDataStream &out, const ExifValueRational &value) {
+    out << qint32(value.num) << qint32(value.den) << qint32(value.type);
+}
+
+ExifValueRational readRational(QDataStream &in) {
+    qint32 num, den, type;
+    in >> num >> den >> type;
+    return ExifValueRational(num, den, RationalType(type));
+}
+
+void writeExif(QDataStream &out, const ExifData &data) {
+    out << data.maker << data.cameraModel << data.lensModel << data.dateTaken << qint32(data.iso);
+    writeRational(out, data.aperture);
+    writeRational(out, data.focalLength);
+    writeRational(out, data.exposureTime);
+    writeRational(out, data.exposureBias);
+    out << qint32(data.flashFired) << data.software << qint32(data.orientation) << qint32(data.width) << qint32(data.height)
+        << data.gpsLatitude << data.gpsLongitude << data.gpsAltitude;
+}
+
+ExifData readExif(QDataStream &in) {
+    ExifData data;
+    qint32 iso, flashFired, orientation, width, height;
+    in >> data.maker >> data.cameraModel >> data.lensModel >> data.dateTaken >> iso;
+    data.aperture = readRational(in);
+    data.focalLength = readRational(in);
+    data.exposureTime = readRational(in);
+    data.exposureBias = readRational(in);
+    in >> flashFired >> data.software >> orientation >> width >> height
+       >> data.gpsLatitude >> data.gpsLongitude >> data.gpsAltitude;
+    data.iso = iso;
+    data.flashFired = flashFired;
+    data.orientation = orientation;
+    data.width = width;
+    data.height = height;
+    return data;
+}
+
+// Counts come from disk, a truncated or corrupted file must not make us allocate for entries that cannot
+// be there. Every entry takes at least minimumBytes of what is left of the file.
+bool readCount(QDataStream &in, quint32 &count, qint64 minimumBytes) {
+    in >> count;
+    if (in.status() != QDataStream::Ok) return false;
+    return qint64(count) * minimumBytes <= in.device()->bytesAvailable();
+}
+}
+
+QString LibrarySnapshot::location() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/snapshot";
+}
+
+QString LibrarySnapshot::fileFor(const QString &root) {
+    const QByteArray hash = QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return location() + '/' + QString::fromLatin1(hash) + ".snapshot";
+}
+
+bool LibrarySnapshot::load(const QString &libraryRoot) {
+    QFile file(fileFor(libraryRoot));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != Magic || version != Version) return false;
+
+    in >> root >> album;
+    if (root != libraryRoot) return false; // a hash collision
+
+    // Smallest encodings: an empty string or list is its 4 byte length, a walked file adds three qint64
+    quint32 count;
+    if (!readCount(in, count, 12)) return false;
+    directories.resize(count);
+    for (WalkedDirectory &directory : directories) {
+        quint32 files;
+        in >> directory.path >> directory.directories;
+        if (!readCount(in, files, 28)) return false;
+        directory.files.resize(files);
+        for (WalkedFile &walked : directory.files)
+            in >> walked.name >> walked.size >> walked.modified >> walked.created;
+        if (in.status() != QDataStream::Ok) return false;
+        directory.summarize();
+    }
+
+    if (!readCount(in, count, 4)) return false;
+    metadata.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString filePath;
+        in >> filePath;
+        metadata.insert(filePath, readExif(in));
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool LibrarySnapshot::save() const {
+    if (!QDir().mkpath(location())) return false;
+
+    QSaveFile file(fileFor(root));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write library snapshot:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << Magic << Version << root << album;
+
+    out << quint32(directories.size());
+    for (const WalkedDirectory &directory : directories) {
+        out << directory.path << directory.directories << quint32(directory.files.size());
+        for (const WalkedFile &walked : directory.files)
+            out << walked.name << walked.size << walked.modified << walked.created;
+    }
+
+    out << quint32(metadata.size());
+    for (auto it = metadata.cbegin(); it != metadata.cend(); ++it) {
+        out << it.key();
+        writeExif(out, it.value());
+    }
+
+    if (!file.commit()) return false;
+
+    // The version 1 snapshot and its thumbnail copies, nothing refers to them any more
+    QFile::remove(location() + "/library.snapshot");
+    QDir(location() + "/thumbnails").removeRecursively();
+    return true;
+}
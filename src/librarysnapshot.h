@@ -0,0 +1,39 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "directorywalker.h"
+#include "structs.h"
+
+// The library tree and the open album of the last session, written on exit and shown at the next launch
+// before the file system has been walked again. Anything stale is corrected by the reconciling scan.
+// There is one file per library root, so indexing another root does not replace the open library's.
+struct LibrarySnapshot {
+    QString root;
+    QString album;
+    QVector<WalkedDirectory> directories; // walker order, parents before their children
+    QHash<QString, ExifData> metadata;    // photos of the album by path
+
+    static QString location();
+    static QString fileFor(const QString &root); // root as an absolute, clean path
+    bool load(const QString &libraryRoot);
+    bool save() const; // replaces the previous snapshot in one rename, thumbnails are in the ThumbnailDiskCache
+};
@@ -0,0 +1,196 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "librarywatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+#if defined(Q_OS_LINUX)
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace {
+// Entry changes only, file contents are covered by IN_CLOSE_WRITE
+constexpr uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE
+                             | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+}
+#endif
+
+LibraryWatcher::LibraryWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(QuietMsecs);
+    connect(&m_debounce, &QTimer::timeout, this, &LibraryWatcher::flush);
+
+    m_pollTimer.setInterval(PollMsecs);
+    connect(&m_pollTimer, &QTimer::timeout, this, &LibraryWatcher::poll);
+
+    connect(&m_fallback, &QFileSystemWatcher::directoryChanged, this, &LibraryWatcher::markDirty);
+
+#if defined(Q_OS_LINUX)
+    m_inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0) {
+        m_notifier = new QSocketNotifier(m_inotify, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &LibraryWatcher::readEvents);
+    }
+    else qWarning() << "inotify unavailable, falling back to QFileSystemWatcher";
+#endif
+}
+
+LibraryWatcher::~LibraryWatcher() {
+#if defined(Q_OS_LINUX)
+    if (m_inotify >= 0) ::close(m_inotify); // drops all watches
+#endif
+}
+
+void LibraryWatcher::clear() {
+#if defined(Q_OS_LINUX)
+    for (auto it = m_watches.cbegin(); it != m_watches.cend(); ++it)
+        ::inotify_rm_watch(m_inotify, it.key());
+    m_watches.clear();
+    m_descriptors.clear();
+#endif
+    if (!m_fallback.directories().isEmpty()) m_fallback.removePaths(m_fallback.directories());
+    m_polled.clear();
+    m_pollTimer.stop();
+    m_dirty.clear();
+    m_debounce.stop();
+}
+
+void LibraryWatcher::watch(const QString &directory) {
+#if defined(Q_OS_LINUX)
+    if (m_inotify >= 0) {
+        const int wd = ::inotify_add_watch(m_inotify, QFile::encodeName(directory).constData(), WatchMask);
+        if (wd >= 0) {
+            m_watches.insert(wd, directory);
+            m_descriptors.insert(directory, wd);
+            return;
+        }
+        // Beyond fs.inotify.max_user_watches, QFileSystemWatcher would hit the same limit
+        if (errno != ENOSPC) return;
+    }
+    else
+#endif
+    if (m_fallback.addPath(directory)) return;
+
+    // Watch limit reached, poll the rest
+    m_polled.insert(directory, QFileInfo(directory).lastModified());
+    if (!m_pollTimer.isActive()) m_pollTimer.start();
+}
+
+void LibraryWatcher::unwatch(const QString &directory) {
+    const QString prefix = directory.endsWith('/') ? directory : directory + '/';
+    auto inside = [&](const QString &path) { return path == directory || path.startsWith(prefix); };
+
+#if defined(Q_OS_LINUX)
+    for (auto it = m_descriptors.begin(); it != m_descriptors.end();) {
+        if (!inside(it.key())) {
+            ++it;
+            continue;
+        }
+        ::inotify_rm_watch(m_inotify, it.value());
+        m_watches.remove(it.value());
+        it = m_descriptors.erase(it);
+    }
+#endif
+    QStringList watched;
+    for (const QString &path : m_fallback.directories())
+        if (inside(path)) watched << path;
+    if (!watched.isEmpty()) m_fallback.removePaths(watched);
+
+    for (auto it = m_polled.begin(); it != m_polled.end();) {
+        if (inside(it.key())) it = m_polled.erase(it);
+        else ++it;
+    }
+    if (m_polled.isEmpty()) m_pollTimer.stop();
+}
+
+#if defined(Q_OS_LINUX)
+void LibraryWatcher::readEvents() {
+    bool overflow = false;
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t bytes = ::read(m_inotify, buffer, sizeof(buffer));
+        if (bytes <= 0) break;
+
+        for (ssize_t offset = 0; offset < bytes;) {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            offset += ssize_t(sizeof(struct inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            const QString directory = m_watches.value(event->wd);
+            if (directory.isEmpty()) continue;
+
+            if (event->mask & IN_IGNORED) {
+                // Watch is gone with its directory
+                m_watches.remove(event->wd);
+                if (m_descriptors.value(directory, -1) == event->wd) m_descriptors.remove(directory);
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                markDirty(QFileInfo(directory).absolutePath());
+                continue;
+            }
+            if (event->len > 0 && event->name[0] == '.') continue; // hidden entries are not part of the library
+            markDirty(directory);
+        }
+    }
+
+    if (overflow) {
+        m_dirty.clear();
+        m_debounce.stop();
+        emit overflowed();
+    }
+}
+#endif
+
+void LibraryWatcher::poll() {
+    for (auto it = m_polled.begin(); it != m_polled.end(); ++it) {
+        const QDateTime modified = QFileInfo(it.key()).lastModified();
+        if (modified == it.value()) continue;
+        it.value() = modified;
+        markDirty(it.key());
+    }
+}
+
+void LibraryWatcher::markDirty(const QString &directory) {
+    if (m_dirty.isEmpty()) m_burst.start();
+    m_dirty.insert(directory);
+
+    // Restart the quiet period, a continuous burst is still reported regularly
+    if (m_burst.elapsed() >= MaxDelayMsecs) flush();
+    else m_debounce.start();
+}
+
+void LibraryWatcher::flush() {
+    m_debounce.stop();
+    if (m_dirty.isEmpty()) return;
+
+    QStringList directories(m_dirty.cbegin(), m_dirty.cend());
+    m_dirty.clear();
+    directories.sort();
+    emit directoriesChanged(directories);
+}
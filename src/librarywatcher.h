@@ -0,0 +1,70 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+class QSocketNotifier;
+
+// Watches the directories of the library and reports the ones whose entries changed.
+// Uses inotify on Linux, QFileSystemWatcher elsewhere, and polls directory modification times
+// for whatever exceeds the platform's watch limit. Bursts of events are debounced into one report.
+class LibraryWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit LibraryWatcher(QObject *parent = nullptr);
+    ~LibraryWatcher();
+
+    void clear();
+    void watch(const QString &directory);
+    void unwatch(const QString &directory); // including its subdirectories
+
+signals:
+    void directoriesChanged(QStringList directories); // sorted, parents before their subdirectories
+    void overflowed();                                // events were lost, the library needs a rescan
+
+private:
+    static constexpr int QuietMsecs = 500;      // report once events stop for this long
+    static constexpr int MaxDelayMsecs = 3000;  // but at least this often during a long burst
+    static constexpr int PollMsecs = 30000;
+
+#if defined(Q_OS_LINUX)
+    int m_inotify = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QHash<int, QString> m_watches;     // watch descriptor -> directory
+    QHash<QString, int> m_descriptors; // directory -> watch descriptor
+    void readEvents();
+#endif
+    QFileSystemWatcher m_fallback;
+    QHash<QString, QDateTime> m_polled; // directory -> last seen modification time
+    QTimer m_pollTimer;
+
+    QSet<QString> m_dirty;
+    QTimer m_debounce;
+    QElapsedTimer m_burst;
+
+    void markDirty(const QString &directory);
+    void flush();
+    void poll();
+};
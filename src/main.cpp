@@ -17,6 +17,8 @@
 */
 
 #include <QApplication>
+#include <QGuiApplication>
+#include <QCommandLineParser>
 #include <QQuickStyle>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
@@ -25,30 +27,15 @@
 #include "photocontroller.h"
 #include "appsettings.h"
 #include "fileservice.h"
+#include "asynclogger.h"
+#include "tracing.h"
+#include "scrolltrace.h"
+#include "libraryindexer.h"
+#include <csignal>
+#include <cstring>
 
 //----- LOGGING -----//
 
-static QFile logFile;
-void messageLogger(QtMsgType type, const QMessageLogContext &ctx, const QString &msg) {
-    if(!logFile.isOpen()) return;
-    QTextStream out(&logFile);
-    QString prefix;
-
-    switch(type) {
-        case QtDebugMsg: prefix = "DEBUG"; break;
-        case QtWarningMsg: prefix = "WARN"; break;
-        case QtCriticalMsg: prefix = "CRIT"; break;
-        case QtFatalMsg: prefix = "FATAL"; break;
-    }
-
-    out << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")
-        << " [" << prefix << "] "
-        << msg << "\n";
-    out.flush();
-
-    if(type == QtFatalMsg) abort();
-}
-
 static QString createSessionLogFile() {
     QDir logDir(QDir::currentPath() + "/logs");
     if(!logDir.exists()) logDir.mkpath(".");
@@ -70,13 +57,49 @@ static void rotateLogs() {
 }
 
 
+//----- INDEXING -----//
+
+// Before an application object exists, so indexing never needs a window system
+static bool isIndexMode(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--index") == 0 || std::strncmp(argv[i], "--index=", 8) == 0) return true;
+    }
+    return false;
+}
+
+static int runIndexer(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setOrganizationName("vorks");
+    QGuiApplication::setOrganizationDomain("vorks.dev");
+    QGuiApplication::setApplicationName("Lysa"); // the same settings and cache location as the application
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Builds thumbnails and metadata of a library for the next launch of Lysa.");
+    parser.addHelpOption();
+    QCommandLineOption indexOption("index", "Index the library at <root> for when Lysa opens it.", "root");
+    parser.addOption(indexOption);
+    QCommandLineOption checkpointOption("checkpoint", "Write a resumable checkpoint every <minutes>, 0 only on exit.", "minutes", "10");
+    parser.addOption(checkpointOption);
+    parser.process(app);
+
+    // Ctrl+C and termination end the run with a checkpoint instead of losing the work
+    std::signal(SIGINT, [](int) { LibraryIndexer::requestStop(); });
+    std::signal(SIGTERM, [](int) { LibraryIndexer::requestStop(); });
+
+    AppSettings settings;
+    LibraryIndexer indexer(&settings);
+    indexer.setCheckpointInterval(parser.value(checkpointOption).toInt() * 60 * 1000);
+    return indexer.run(parser.value(indexOption));
+}
+
+
 //----- MAIN -----//
 
 int main(int argc, char *argv[]) {
     rotateLogs();
-    logFile.setFileName(createSessionLogFile());
-    logFile.open(QIODevice::WriteOnly |QIODevice::Text);
-    qInstallMessageHandler(messageLogger);
+    AsyncLogger logger(createSessionLogFile()); // installs itself as the message handler until main returns
+    if (isIndexMode(argc, argv)) return runIndexer(argc, argv);
 
     QApplication app(argc, argv);
     QApplication::setOrganizationName("vorks");
@@ -85,25 +108,49 @@ int main(int argc, char *argv[]) {
     QQuickStyle::setStyle(QStringLiteral("Fusion"));
     QApplication::setWindowIcon(QIcon(":/icons/lysa.svg"));
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption traceOption("trace", "Record performance trace spans and write them to <file> as Chrome trace JSON on exit.", "file");
+    parser.addOption(traceOption);
+    QCommandLineOption recordScrollOption("record-scroll", "Record the gallery's thumbnail requests and write them to <file> on exit, for lysa-scrollbench.", "file");
+    parser.addOption(recordScrollOption);
+    parser.addOption({"index", "Index the library at <root> without a window and exit.", "root"});
+    parser.process(app);
+
     // Create settings instance
     AppSettings settings;
 
-    // Create photo controller
-    PhotoController controller(&settings);
+    // Tracing starts before anything loads, the command line wins over the setting
+    const QString tracePath = parser.isSet(traceOption) ? parser.value(traceOption) : settings.value<QString>("traceFile");
+    if (!tracePath.isEmpty()) Tracer::setEnabled(true);
+
+    ScrollTrace scrollTrace;
+    int result = 0;
+    {
+        // Create photo controller
+        PhotoController controller(&settings);
+        if (parser.isSet(recordScrollOption)) controller.galleryModel()->setScrollRecorder(&scrollTrace);
 
-    // Create TxtReader
-    FileService fileService;
+        // Create TxtReader
+        FileService fileService;
 
-    QQmlApplicationEngine engine;
+        QQmlApplicationEngine engine;
 
-    // Expose C++ objects to QML
-    engine.rootContext()->setContextProperty("galleryModel", controller.galleryModel());
-    engine.rootContext()->setContextProperty("directoryModel", controller.dirs());
-    engine.rootContext()->setContextProperty("photoController", &controller);
-    engine.rootContext()->setContextProperty("settingsModel", &settings);
-    engine.rootContext()->setContextProperty("fileService", &fileService);
+        // Expose C++ objects to QML
+        engine.rootContext()->setContextProperty("galleryModel", controller.galleryModel());
+        engine.rootContext()->setContextProperty("directoryModel", controller.dirs());
+        engine.rootContext()->setContextProperty("photoController", &controller);
+        engine.rootContext()->setContextProperty("performanceMetrics", controller.metrics());
+        engine.rootContext()->setContextProperty("settingsModel", &settings);
+        engine.rootContext()->setContextProperty("fileService", &fileService);
 
-    engine.load(QUrl("qrc:/main.qml"));
+        engine.load(QUrl("qrc:/main.qml"));
+
+        result = app.exec();
+    }
 
-    return app.exec();
+    // After the controller is gone, so shutdown work like the snapshot is part of the trace
+    if (!tracePath.isEmpty()) Tracer::writeChromeTrace(tracePath);
+    if (parser.isSet(recordScrollOption)) scrollTrace.save(parser.value(recordScrollOption));
+    return result;
 }
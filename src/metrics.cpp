@@ -0,0 +1,195 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "metrics.h"
+#include "photomodel.h"
+#include "taskscheduler.h"
+#include <QDebug>
+#include <algorithm>
+
+Metrics::PoolState Metrics::s_pools[Metrics::PoolCount];
+std::atomic<int64_t> Metrics::s_counters[Metrics::CounterCount];
+std::atomic<int64_t> Metrics::s_latencies[Metrics::LatencyCount][Metrics::Buckets];
+std::atomic<int64_t> Metrics::s_guiNanoseconds {0};
+thread_local int Metrics::s_guiDepth = 0;
+
+namespace {
+const char *poolNames[Metrics::PoolCount] = { "thumbnails", "exif", "providers", "loading", "settings" };
+const char *laneNames[TaskScheduler::LaneCount] = { "cpu", "io", "coordinator" };
+const char *latencyNames[Metrics::LatencyCount] = { "thumbnailDecode", "exifRead", "photoDecode" };
+}
+
+//----- Metrics -----//
+
+void Metrics::recordLatency(Latency latency, int64_t nanoseconds) {
+    int bucket = 0;
+    for (int64_t microseconds = nanoseconds / 1000; microseconds > 1 && bucket < Buckets - 1; microseconds >>= 1)
+        ++bucket;
+    s_latencies[latency][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+Metrics::Histogram Metrics::histogram(Latency latency) {
+    Histogram histogram;
+    for (int bucket = 0; bucket < Buckets; ++bucket)
+        histogram[bucket] = s_latencies[latency][bucket].load(std::memory_order_relaxed);
+    return histogram;
+}
+
+
+//----- MetricsRegistry -----//
+
+MetricsRegistry::MetricsRegistry(const PhotoModel *model, QObject *parent)
+    : QObject(parent), m_model(model) {
+    m_timer.setInterval(SampleIntervalMsecs);
+    connect(&m_timer, &QTimer::timeout, this, &MetricsRegistry::sample);
+    m_sampleClock.start();
+}
+
+void MetricsRegistry::setActive(bool active) {
+    if (active == m_timer.isActive()) return;
+    if (active) {
+        sample(); // starts the rate window, the first rates appear a second later
+        m_timer.start();
+    }
+    else m_timer.stop();
+    emit activeChanged();
+}
+
+QVariantMap MetricsRegistry::percentiles(const Metrics::Histogram &histogram) {
+    qint64 total = 0;
+    for (int64_t count : histogram)
+        total += count;
+    if (total == 0) return {};
+
+    // Interpolated inside the bucket, which spans a factor of two
+    auto percentile = [&](double q) {
+        const double target = q * double(total);
+        double seen = 0;
+        for (int bucket = 0; bucket < Metrics::Buckets; ++bucket) {
+            if (histogram[bucket] == 0) continue;
+            if (seen + double(histogram[bucket]) >= target) {
+                const double low = bucket == 0 ? 0.0 : double(int64_t(1) << bucket);
+                const double high = double(int64_t(1) << (bucket + 1));
+                const double fraction = (target - seen) / double(histogram[bucket]);
+                return (low + fraction * (high - low)) / 1000.0; // msecs
+            }
+            seen += double(histogram[bucket]);
+        }
+        return 0.0;
+    };
+
+    return {
+        { "count", total },
+        { "p50", percentile(0.50) },
+        { "p90", percentile(0.90) },
+        { "p99", percentile(0.99) }
+    };
+}
+
+void MetricsRegistry::sample() {
+    const double seconds = std::max(m_sampleClock.restart(), qint64(1)) / 1000.0;
+    QVariantMap values;
+
+    QVariantList pools;
+    for (int pool = 0; pool < Metrics::PoolCount; ++pool) {
+        pools.append(QVariantMap {
+            { "name", poolNames[pool] },
+            { "queued", qint64(Metrics::queueDepth(Metrics::Pool(pool))) },
+            { "active", qint64(Metrics::activeTasks(Metrics::Pool(pool))) }
+        });
+    }
+    values.insert("pools", pools);
+
+    const TaskScheduler &scheduler = TaskScheduler::instance();
+    QVariantList lanes;
+    for (int lane = 0; lane < TaskScheduler::LaneCount; ++lane) {
+        lanes.append(QVariantMap {
+            { "name", laneNames[lane] },
+            { "busy", scheduler.busyThreads(TaskScheduler::Lane(lane)) },
+            { "threads", scheduler.threadCount(TaskScheduler::Lane(lane)) }
+        });
+    }
+    values.insert("lanes", lanes);
+
+    const int64_t thumbnails = Metrics::counter(Metrics::ThumbnailsGenerated);
+    values.insert("thumbnailsPerSecond", double(thumbnails - m_lastThumbnails) / seconds);
+    m_lastThumbnails = thumbnails;
+
+    // Percentiles of what was measured since the last sample
+    for (int latency = 0; latency < Metrics::LatencyCount; ++latency) {
+        const Metrics::Histogram current = Metrics::histogram(Metrics::Latency(latency));
+        Metrics::Histogram window;
+        for (int bucket = 0; bucket < Metrics::Buckets; ++bucket)
+            window[bucket] = current[bucket] - m_lastHistograms[latency][bucket];
+        m_lastHistograms[latency] = current;
+
+        const QVariantMap result = percentiles(window);
+        if (!result.isEmpty()) m_lastLatencies.insert(latencyNames[latency], result);
+    }
+    values.insert("latencies", m_lastLatencies);
+
+    const int64_t guiNanoseconds = Metrics::guiNanoseconds();
+    values.insert("guiModelLoad", double(guiNanoseconds - m_lastGuiNanoseconds) / 1e9 / seconds); // fraction of wall time
+    m_lastGuiNanoseconds = guiNanoseconds;
+
+    const QVariantMap thumbnails = m_model->thumbnailMetrics();
+    values.insert("thumbnailHitRate", thumbnails.value("hitRate"));
+    values.insert("thumbnailCount", thumbnails.value("residentCount"));
+    values.insert("thumbnailBytes", thumbnails.value("residentBytes"));
+    values.insert("thumbnailBudgetBytes", thumbnails.value("budgetBytes"));
+    const QVariantMap providers = m_model->providerMetrics();
+    values.insert("providerCount", providers.value("count"));
+    values.insert("providerBytes", providers.value("bytes"));
+    values.insert("photoBytes", m_model->memoryMetrics().value("bytes"));
+
+    m_values = values;
+    emit valuesChanged();
+}
+
+void MetricsRegistry::dumpToLog() {
+    sample();
+
+    for (const QVariant &entry : m_values.value("pools").toList()) {
+        const QVariantMap pool = entry.toMap();
+        qInfo().noquote() << QStringLiteral("Metrics: pool %1 queued %2, running %3").arg(pool.value("name").toString())
+            .arg(pool.value("queued").toLongLong()).arg(pool.value("active").toLongLong());
+    }
+    for (const QVariant &entry : m_values.value("lanes").toList()) {
+        const QVariantMap lane = entry.toMap();
+        qInfo().noquote() << QStringLiteral("Metrics: %1 lane busy %2/%3").arg(lane.value("name").toString())
+            .arg(lane.value("busy").toInt()).arg(lane.value("threads").toInt());
+    }
+
+    const QVariantMap latencies = m_values.value("latencies").toMap();
+    for (auto it = latencies.cbegin(); it != latencies.cend(); ++it) {
+        const QVariantMap latency = it.value().toMap();
+        qInfo().noquote() << QStringLiteral("Metrics: %1 p50 %2 ms, p90 %3 ms, p99 %4 ms over %5").arg(it.key())
+            .arg(latency.value("p50").toDouble(), 0, 'f', 2).arg(latency.value("p90").toDouble(), 0, 'f', 2)
+            .arg(latency.value("p99").toDouble(), 0, 'f', 2).arg(latency.value("count").toLongLong());
+    }
+
+    qInfo().noquote() << QStringLiteral("Metrics: %1 thumbnails/s, hit rate %2%, %3 thumbnails in %4 of %5 bytes")
+        .arg(m_values.value("thumbnailsPerSecond").toDouble(), 0, 'f', 1)
+        .arg(m_values.value("thumbnailHitRate").toDouble() * 100.0, 0, 'f', 1)
+        .arg(m_values.value("thumbnailCount").toInt())
+        .arg(m_values.value("thumbnailBytes").toLongLong()).arg(m_values.value("thumbnailBudgetBytes").toLongLong());
+    qInfo().noquote() << QStringLiteral("Metrics: %1 providers with %2 bytes, %3 bytes of photo rows, GUI thread %4% in model operations")
+        .arg(m_values.value("providerCount").toInt()).arg(m_values.value("providerBytes").toLongLong())
+        .arg(m_values.value("photoBytes").toLongLong())
+        .arg(m_values.value("guiModelLoad").toDouble() * 100.0, 0, 'f', 1);
+}
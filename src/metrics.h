@@ -0,0 +1,134 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "tracing.h"
+
+class PhotoModel;
+
+// Process-wide counters, written from any thread with relaxed atomics. MetricsRegistry samples them
+// into rates and percentiles, nothing here allocates or locks.
+class Metrics {
+public:
+    enum Pool { ThumbnailPool, ExifPool, ProviderPool, LoadingPool, SettingsPool, PoolCount };
+    enum Latency { ThumbnailDecode, ExifRead, PhotoDecode, LatencyCount };
+    enum Counter { ThumbnailsGenerated, ThumbnailsCached, CounterCount }; // decoded, found in the disk cache
+
+    // Bucket i holds latencies in [2^i, 2^(i+1)) microseconds
+    static constexpr int Buckets = 32;
+    using Histogram = std::array<int64_t, Buckets>;
+
+    // Tasks of each TaskGroup, reported by the TaskScheduler
+    static void queued(Pool pool, int tasks = 1) { s_pools[pool].queued.fetch_add(tasks, std::memory_order_relaxed); }
+    static void dropped(Pool pool, int tasks) { s_pools[pool].queued.fetch_sub(tasks, std::memory_order_relaxed); }
+    static void started(Pool pool) {
+        s_pools[pool].queued.fetch_sub(1, std::memory_order_relaxed);
+        s_pools[pool].active.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void finished(Pool pool) { s_pools[pool].active.fetch_sub(1, std::memory_order_relaxed); }
+    static int64_t queueDepth(Pool pool) { return std::max<int64_t>(s_pools[pool].queued.load(std::memory_order_relaxed), 0); }
+    static int64_t activeTasks(Pool pool) { return std::max<int64_t>(s_pools[pool].active.load(std::memory_order_relaxed), 0); }
+    static bool idle(Pool pool) { return queueDepth(pool) == 0 && activeTasks(pool) == 0; }
+
+    static void count(Counter counter, int64_t amount = 1) { s_counters[counter].fetch_add(amount, std::memory_order_relaxed); }
+    static int64_t counter(Counter counter) { return s_counters[counter].load(std::memory_order_relaxed); }
+
+    static void recordLatency(Latency latency, int64_t nanoseconds);
+    static Histogram histogram(Latency latency);
+
+    static int64_t now() { return Tracer::now(); } // the clock of the trace spans, so both line up
+    static int64_t guiNanoseconds() { return s_guiNanoseconds.load(std::memory_order_relaxed); }
+
+    // Measures the scope into a latency histogram
+    class LatencyScope {
+    public:
+        explicit LatencyScope(Latency latency) : m_latency(latency), m_start(now()) {}
+        ~LatencyScope() { recordLatency(m_latency, now() - m_start); }
+    private:
+        Latency m_latency;
+        int64_t m_start;
+    };
+
+    // GUI thread time spent in model operations, nested scopes only count once
+    class GuiScope {
+    public:
+        GuiScope() : m_start(s_guiDepth++ == 0 ? now() : -1) {}
+        ~GuiScope() {
+            --s_guiDepth;
+            if (m_start >= 0) s_guiNanoseconds.fetch_add(now() - m_start, std::memory_order_relaxed);
+        }
+    private:
+        int64_t m_start;
+    };
+
+private:
+    struct PoolState {
+        std::atomic<int64_t> queued {0};
+        std::atomic<int64_t> active {0};
+    };
+
+    static PoolState s_pools[PoolCount];
+    static std::atomic<int64_t> s_counters[CounterCount];
+    static std::atomic<int64_t> s_latencies[LatencyCount][Buckets];
+    static std::atomic<int64_t> s_guiNanoseconds;
+    static thread_local int s_guiDepth;
+};
+
+// Live view of Metrics for the QML overlay and the log. Samples once a second while active.
+class MetricsRegistry : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(QVariantMap values READ values NOTIFY valuesChanged)
+public:
+    explicit MetricsRegistry(const PhotoModel *model, QObject *parent = nullptr);
+
+    bool active() const { return m_timer.isActive(); }
+    void setActive(bool active);
+    QVariantMap values() const { return m_values; }
+
+    Q_INVOKABLE void sample();
+    Q_INVOKABLE void dumpToLog();
+
+    static QVariantMap percentiles(const Metrics::Histogram &histogram); // count, p50, p90, p99 in msecs
+
+signals:
+    void activeChanged();
+    void valuesChanged();
+
+private:
+    static constexpr int SampleIntervalMsecs = 1000;
+
+    const PhotoModel *m_model;
+    QTimer m_timer;
+    QVariantMap m_values;
+
+    // State of the previous sample, rates and percentiles cover the time since
+    QElapsedTimer m_sampleClock;
+    int64_t m_lastThumbnails = 0;
+    int64_t m_lastGuiNanoseconds = 0;
+    Metrics::Histogram m_lastHistograms[Metrics::LatencyCount] = {};
+    QVariantMap m_lastLatencies; // kept while nothing was decoded
+};
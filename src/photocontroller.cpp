@@ -17,15 +17,25 @@
 */
 
 #include "photocontroller.h"
+#include "directorywalker.h"
+#include "librarysnapshot.h"
+#include "tracing.h"
+#include "metrics.h"
 #include <QFileDialog>
-#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPointer>
 #include <QSettings>
-#include <QtConcurrent>
 #include <QDebug>
 
+namespace {
+const QStringList photoSuffixes = {"jpg", "jpeg", "png", "bmp"};
+}
+
 PhotoController::PhotoController(AppSettings *settings, QObject *parent)
-    : QObject(parent), m_settings(settings), m_model(settings), m_galleryModel(settings, m_model, this), m_directories(m_settings)
+    : QObject(parent), m_settings(settings), m_model(settings), m_galleryModel(settings, m_model, this), m_directories(m_settings), m_metrics(&m_model)
 {
+    m_directories.setLibrary(&m_library);
 
     connect(&m_directories, &DirectoryModel::activePathChanged,
             this, &PhotoController::fillPhotoModel);
@@ -33,26 +43,39 @@ PhotoController::PhotoController(AppSettings *settings, QObject *parent)
     connect(m_settings, &AppSettings::settingChanged,
             this, &PhotoController::onSettingChanged);
 
-    connect(this, &PhotoController::dirsFound, this, [this](const QStringList &dirs){
-        for (const QString &path : dirs)
-        m_directories.addDirectory(path);
-    }, Qt::QueuedConnection);
+    connect(this, &PhotoController::directoriesScanned,
+            this, &PhotoController::onDirectoriesScanned, Qt::QueuedConnection);
+
+    connect(this, &PhotoController::directoryTreeBuilt,
+            this, &PhotoController::onDirectoryTreeBuilt, Qt::QueuedConnection);
+
+    connect(this, &PhotoController::scanFinished,
+            this, &PhotoController::onScanFinished, Qt::QueuedConnection);
+
+    connect(this, &PhotoController::directoriesListed,
+            this, &PhotoController::onDirectoriesListed, Qt::QueuedConnection);
+
+    connect(&m_watcher, &LibraryWatcher::directoriesChanged,
+            this, &PhotoController::onDirectoriesChanged);
+
+    // Streamed rows and metadata are merged into the gallery, one full sort once both have settled
+    connect(&m_model, &PhotoModel::metadataFinished, this, [this]() {
+        if (!m_scanning) m_galleryModel.settleSort();
+    });
 
-    connect(this, &PhotoController::photosFound, this, [this](const QStringList &files){
-                for (const QString &path : files)
-                m_model.addPhoto(path);
-                m_model.batchChangeFinished();
-            }, Qt::QueuedConnection);
+    // Lost events leave the index unreliable, start over
+    connect(&m_watcher, &LibraryWatcher::overflowed, this, [this]() {
+        loadFolder(m_rootFolder);
+    });
 
-    QString rootFolder = m_settings->getValue("rootFolder").toString();
-    setRootFolder(rootFolder);
+    QString rootFolder = m_settings->value<QString>("rootFolder");
+    if (!restoreSnapshot(rootFolder)) setRootFolder(rootFolder);
 }
 
 PhotoController::~PhotoController() {
-    ++m_dirGeneration;
-    ++m_photoGeneration;
-    m_dirScanFuture.cancel();
-    m_photoScanFuture.cancel();
+    ++m_scanGeneration;
+    m_scanToken.cancel();
+    saveSnapshot();
 }
 
 void PhotoController::onSettingChanged(const QString &id, const QVariant &value) {
@@ -70,54 +93,300 @@ void PhotoController::setRootFolder(const QString &folder) {
 }
 
 void PhotoController::loadFolder(const QString &folder) {
-    QString openedDirectory = m_settings->getValue("openedDirectory").toString();
-    if(openedDirectory.isEmpty()) m_directories.setActivePath(folder);
-    else m_directories.setActivePath(openedDirectory);
-
+    m_reconciling = false;
+    m_watcher.clear();
+    m_library.clear();
     m_directories.clear();
     m_directories.setRootPath(folder);
+    m_directories.beginBuild();
+
+    QString openedDirectory = m_settings->value<QString>("openedDirectory");
+    const QString activePath = openedDirectory.isEmpty() ? folder : openedDirectory;
+    if (m_directories.activePath() == activePath) fillPhotoModel(activePath); // same album, refill from the new scan
+    else m_directories.setActivePath(activePath);
+
+    int gen = restartScans();
+    scanDirectories({ QDir::cleanPath(QFileInfo(folder).absoluteFilePath()) }, gen, true);
+}
 
-    int gen = ++m_dirGeneration;
+int PhotoController::restartScans() {
+    // Work of the previous root stops at the next directory instead of running to completion
+    m_scanToken.cancel();
+    m_scanToken = CancellationToken();
+    m_relisting.clear(); // cancelled listings never report
+    m_relistPending.clear();
+    return ++m_scanGeneration;
+}
+
+void PhotoController::scanDirectories(const QStringList &roots, int generation, bool fullScan) {
     QPointer<PhotoController> guard(this);
+    const CancellationToken cancellation = m_scanToken;
+    const bool buildTree = fullScan && !m_reconciling; // reconciling updates the restored tree in place
+    if (fullScan) m_scanning = true;
+
+    // Only a fresh scan has nothing on screen yet, reconciling and new subtrees run behind everything else
+    const TaskScheduler::Priority priority = buildTree ? TaskScheduler::Visible : TaskScheduler::Background;
+    // The walk mostly waits for its listings, it must not hold one of the I/O workers they run on
+    m_loadingTasks.run(priority, TaskScheduler::CoordinatorLane, [roots, generation, fullScan, buildTree, priority, guard, cancellation]() {
+        if (!guard || cancellation.isCancelled()) return;
+        LYSA_TRACE_SCOPE("scan", "PhotoController::scanDirectories");
+
+        // A fresh scan publishes the tree as soon as the root's first level is known, deeper levels are
+        // added from the batches, silently as long as their parents are collapsed
+        bool treePublished = !buildTree;
 
-    if(m_dirScanFuture.isRunning()) m_dirScanFuture.cancel();
+        // Streamed in bounded batches, so the tree and the active album fill while the walk runs
+        const int maxBatchPhotos = 2000;
+        const qint64 maxBatchMsecs = 50;
 
-    m_dirScanFuture = QtConcurrent::run(&m_loadingPool, [folder, gen, guard]() {
-        if (!guard) return;
+        QVector<ScannedDirectory> batch;
+        int batchPhotos = 0;
+        QElapsedTimer batchTimer;
+        batchTimer.start();
+        // Listings queue behind metadata reads and settings writes, a fresh scan ahead of other background work
+        const DirectoryWalker walker(photoSuffixes, priority == TaskScheduler::Visible ? TaskScheduler::Prefetch : TaskScheduler::Background);
+        for (const QString &root : roots) {
+            walker.walk(root, [&](const WalkedDirectory &directory) {
+                if (!guard) return false;
 
-        QStringList dirs;
-        QDirIterator dirIt(folder, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-        while (dirIt.hasNext()) {
-            dirs << dirIt.next();
+                if (!treePublished) {
+                    auto tree = std::make_shared<DirectoryTree>();
+                    tree->add(directory);
+                    emit guard->directoryTreeBuilt(tree, generation); // ahead of the batch with the root
+                    treePublished = true;
+                }
+
+                // A directory larger than what is left of the batch continues in the next ones
+                const int files = directory.files.size();
+                int first = 0;
+                do {
+                    const int count = qMin(files - first, maxBatchPhotos - batchPhotos);
+                    batch.append({ directory, first, count });
+                    batchPhotos += count;
+                    first += count;
+                    if (batchPhotos < maxBatchPhotos && batchTimer.elapsed() < maxBatchMsecs) continue;
+
+                    emit guard->directoriesScanned(batch, generation);
+                    batch.clear();
+                    batchPhotos = 0;
+                    batchTimer.restart();
+                } while (first < files);
+                return true;
+            }, cancellation);
         }
 
-        if (!guard || gen != guard->m_dirGeneration) return; // discard stale results
+        if (!guard || cancellation.isCancelled()) return; // discard stale results
 
-        emit guard->dirsFound(dirs);
+        if (!batch.isEmpty()) emit guard->directoriesScanned(batch, generation);
+        if (fullScan) emit guard->scanFinished(generation);
     });
 }
 
-void PhotoController::fillPhotoModel(const QString &folder) {
-    m_model.clear();
+void PhotoController::onDirectoriesScanned(const QVector<ScannedDirectory> &directories, int generation) {
+    if (generation != m_scanGeneration) return; // batch of a previous root
+    LYSA_TRACE_SCOPE("scan", "PhotoController::onDirectoriesScanned");
+    Metrics::GuiScope guiTime;
 
-    int gen = ++m_photoGeneration;
-    QPointer<PhotoController> guard(this);
+    QVector<PhotoFile> photos;
+    LibraryIndex::Changes changes;
+    for (const ScannedDirectory &scanned : directories) {
+        const WalkedDirectory &directory = scanned.directory;
+        if (scanned.firstFile == 0) {
+            // Directories known from the snapshot are compared, new ones are added like in a fresh scan
+            m_reconciledDirectory.clear();
+            const int id = m_library.find(directory.path);
+            if (m_reconciling && id >= 0 && m_library.directory(id).scanned) {
+                m_library.updateDirectory(directory, changes);
+                m_watcher.watch(directory.path);
+                m_reconciledDirectory = directory.path; // its further pieces are covered by the changes
+                continue;
+            }
+
+            if (m_library.addDirectory(directory) < 0) continue; // removed while it was scanned
+            m_watcher.watch(directory.path);
+            m_directories.addDirectories(directory);
+        }
+        else if (directory.path == m_reconciledDirectory || m_library.find(directory.path) < 0) continue;
+
+        // The active album fills progressively while the scan is running
+        if (!LibraryIndex::isInside(directory.path, m_activeAlbum)) continue;
+        for (int i = scanned.firstFile; i < scanned.firstFile + scanned.fileCount; ++i)
+            photos << LibraryIndex::photoFile(directory.path, directory.files[i]);
+    }
 
-    if(m_photoScanFuture.isRunning()) m_photoScanFuture.cancel();
+    if (!photos.isEmpty()) showPhotos(photos);
+    if (!changes.isEmpty()) applyChanges(changes, generation, false); // the running walk reaches new subtrees itself
+}
+
+void PhotoController::onDirectoryTreeBuilt(const std::shared_ptr<DirectoryTree> &tree, int generation) {
+    if (generation != m_scanGeneration) return;
+    LYSA_TRACE_SCOPE("scan", "DirectoryModel::setTree");
+    Metrics::GuiScope guiTime;
+    m_directories.setTree(std::move(*tree));
+}
 
-    m_photoScanFuture = QtConcurrent::run(&m_loadingPool, [folder, gen, guard]() {
-        if (!guard) return;
+void PhotoController::onScanFinished(int generation) {
+    if (generation != m_scanGeneration) return;
 
-        QStringList files;
-        QDirIterator it(folder,
-                        {"*.jpg","*.jpeg","*.png","*.bmp"},
-                        QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            files << it.next();
+    m_reconciling = false;
+    m_library.setComplete(true);
+    m_directories.aggregatesChanged();
+    m_scanning = false;
+    if (!m_model.loadingMetadata()) m_galleryModel.settleSort();
+
+    // Empty albums still report once to finish loading
+    if (m_albumPending) showPhotos({});
+}
+
+void PhotoController::onDirectoriesChanged(const QStringList &changed) {
+    // One re-listing per directory at a time, a listing that finished late would overwrite a newer one.
+    // Directories that change again meanwhile are listed once more when the running listing arrives.
+    QStringList directories;
+    for (const QString &path : changed) {
+        const QString directory = QDir::cleanPath(path); // as listings report it
+        if (m_relisting.contains(directory)) m_relistPending.insert(directory);
+        else {
+            m_relisting.insert(directory);
+            directories << directory;
         }
+    }
+    if (directories.isEmpty()) return;
 
-        if (!guard || gen != guard->m_photoGeneration) return; // discard stale results
+    const int gen = m_scanGeneration;
+    QPointer<PhotoController> guard(this);
+    const CancellationToken cancellation = m_scanToken;
 
-        emit guard->photosFound(files);
+    // Re-list only the changed directories, off the GUI thread
+    m_loadingTasks.run(TaskScheduler::Background, TaskScheduler::IoLane, [directories, gen, guard, cancellation]() {
+        LYSA_TRACE_SCOPE("scan", "PhotoController::listChangedDirectories");
+        QVector<WalkedDirectory> listings;
+        QStringList missing;
+        const DirectoryWalker walker(photoSuffixes);
+        for (const QString &directory : directories) {
+            if (!guard || cancellation.isCancelled()) return;
+            if (QFileInfo(directory).isDir()) listings.append(walker.list(directory));
+            else missing << directory;
+        }
+
+        if (!guard || cancellation.isCancelled()) return; // discard stale results
+        emit guard->directoriesListed(listings, missing, gen);
     });
 }
+
+void PhotoController::onDirectoriesListed(const QVector<WalkedDirectory> &listings, const QStringList &missing, int generation) {
+    if (generation != m_scanGeneration) return;
+
+    QStringList again;
+    const auto finished = [&](const QString &path) {
+        m_relisting.remove(path);
+        if (m_relistPending.remove(path)) again << path;
+    };
+
+    LibraryIndex::Changes changes;
+    for (const QString &path : missing) {
+        finished(path);
+        m_library.removeDirectory(path, changes);
+    }
+    for (const WalkedDirectory &listing : listings) {
+        finished(listing.path);
+        m_library.updateDirectory(listing, changes);
+    }
+    if (!changes.isEmpty()) applyChanges(changes, generation, true);
+    if (!again.isEmpty()) onDirectoriesChanged(again);
+}
+
+void PhotoController::applyChanges(const LibraryIndex::Changes &changes, int generation, bool scanAdded) {
+    LYSA_TRACE_SCOPE("library", "PhotoController::applyChanges");
+    Metrics::GuiScope guiTime;
+    QString activePath;
+    for (const QString &path : changes.removedDirectories) {
+        m_watcher.unwatch(path);
+        m_directories.removeDirectory(path);
+        if (LibraryIndex::isInside(m_activeAlbum, path)) activePath = QFileInfo(path).absolutePath();
+    }
+    for (const QString &path : changes.addedDirectories)
+        m_directories.addDirectory(path);
+
+    // Only the active album is in the photo model, the model ignores unknown paths
+    m_model.removePhotos(changes.removedPhotos);
+    m_model.invalidatePhotos(changes.modifiedPhotos);
+    QVector<PhotoFile> added;
+    for (const PhotoFile &photo : changes.addedPhotos)
+        if (LibraryIndex::isInside(photo.filePath, m_activeAlbum)) added << photo;
+    if (!added.isEmpty()) showPhotos(added);
+
+    // New subtrees are walked like the initial scan and arrive through onDirectoriesScanned
+    if (scanAdded && !changes.addedDirectories.isEmpty()) scanDirectories(changes.addedDirectories, generation, false);
+
+    m_directories.aggregatesChanged();
+
+    // The active album itself is gone, fall back to its closest remaining parent
+    if (!activePath.isEmpty()) m_directories.setActivePath(activePath);
+}
+
+void PhotoController::fillPhotoModel(const QString &folder) {
+    LYSA_TRACE_SCOPE("library", "PhotoController::fillPhotoModel");
+    Metrics::GuiScope guiTime;
+    m_model.clear();
+    m_activeAlbum = QDir::cleanPath(folder);
+    m_albumPending = true;
+
+    // Album switches are a lookup, directories that are still being scanned are added once they arrive
+    const QVector<PhotoFile> photos = m_library.photoFiles(m_activeAlbum);
+    if (!photos.isEmpty() || m_library.isComplete()) showPhotos(photos);
+}
+
+void PhotoController::showPhotos(const QVector<PhotoFile> &photos) {
+    LYSA_TRACE_SCOPE("library", "PhotoController::showPhotos");
+    Metrics::GuiScope guiTime;
+    m_model.addPhotos(photos);
+    m_model.batchChangeFinished();
+    m_albumPending = false;
+}
+
+//----- Session snapshot -----//
+
+bool PhotoController::restoreSnapshot(const QString &folder) {
+    if (folder.isEmpty() || !QDir(folder).exists()) return false;
+    LYSA_TRACE_SCOPE("snapshot", "PhotoController::restoreSnapshot");
+    Metrics::GuiScope guiTime;
+
+    LibrarySnapshot snapshot;
+    const QString root = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+    if (!snapshot.load(root) || snapshot.directories.isEmpty()) return false;
+
+    m_rootFolder = folder;
+    m_directories.setRootPath(folder);
+    DirectoryTree tree;
+    for (const WalkedDirectory &directory : snapshot.directories) {
+        if (m_library.addDirectory(directory) < 0) continue;
+        tree.add(directory);
+    }
+    m_directories.setTree(std::move(tree));
+    m_library.setComplete(true);
+
+    // Metadata first, so the album sorts without waiting for EXIF extraction
+    m_model.restoreMetadata(snapshot.metadata);
+    QString openedDirectory = m_settings->value<QString>("openedDirectory");
+    const QString activePath = openedDirectory.isEmpty() ? folder : openedDirectory;
+    if (m_directories.activePath() == activePath) fillPhotoModel(activePath);
+    else m_directories.setActivePath(activePath);
+
+    // The walk reports every directory again, differences reach the models as changes
+    m_reconciling = true;
+    const int gen = restartScans();
+    scanDirectories({ root }, gen, true);
+    return true;
+}
+
+void PhotoController::saveSnapshot() const {
+    if (m_rootFolder.isEmpty() || !m_library.isComplete()) return;
+    LYSA_TRACE_SCOPE("snapshot", "PhotoController::saveSnapshot");
+
+    LibrarySnapshot snapshot;
+    snapshot.root = QDir::cleanPath(QFileInfo(m_rootFolder).absoluteFilePath());
+    snapshot.album = m_activeAlbum;
+    snapshot.directories = m_library.directories();
+    snapshot.metadata = m_model.metadata();
+    snapshot.save();
+}
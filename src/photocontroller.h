@@ -18,13 +18,26 @@
 
 #pragma once
 #include <QObject>
-#include <QThreadPool>
+#include <QSet>
 #include "photomodel.h"
 #include "gallerymodel.h"
 #include "thumbnailworker.h"
 #include "directorymodel.h"
+#include "libraryindex.h"
+#include "librarywatcher.h"
+#include "cancellationtoken.h"
+#include "metrics.h"
+#include "taskscheduler.h"
 #include "appsettings.h"
 
+// A walked directory as part of a scan batch. Large directories are spread over several batches, every
+// piece shares the listing: the index takes it with the first piece, the album adds each piece's files.
+struct ScannedDirectory {
+    WalkedDirectory directory;
+    int firstFile = 0;
+    int fileCount = 0;
+};
+
 class PhotoController : public QObject {
     Q_OBJECT
 public:
@@ -39,22 +52,47 @@ public:
 
     GalleryModel* galleryModel() { return &m_galleryModel; }
     DirectoryModel* dirs() { return &m_directories; }
+    MetricsRegistry* metrics() { return &m_metrics; }
+    PhotoModel* photoModel() { return &m_model; }
+
+    void saveSnapshot() const; // on destruction, or as a checkpoint of long runs
 
 signals:
-    void dirsFound(QStringList dirs);
-    void photosFound(QStringList files);
+    void directoriesScanned(QVector<ScannedDirectory> directories, int generation);
+    void directoryTreeBuilt(std::shared_ptr<DirectoryTree> tree, int generation);
+    void scanFinished(int generation);
+    void directoriesListed(QVector<WalkedDirectory> listings, QStringList missing, int generation);
 
 private:
     AppSettings *m_settings; // injected from main.cpp
     PhotoModel m_model;
     GalleryModel m_galleryModel;
     DirectoryModel m_directories;
+    MetricsRegistry m_metrics;
+    LibraryIndex m_library;
+    LibraryWatcher m_watcher;
 
-    QThreadPool m_loadingPool;
-    QFuture<void> m_dirScanFuture;
-    QFuture<void> m_photoScanFuture;
-    std::atomic<int> m_dirGeneration {0};
-    std::atomic<int> m_photoGeneration {0};
+    TaskGroup m_loadingTasks { Metrics::LoadingPool };
+    std::atomic<int> m_scanGeneration {0};
+    CancellationToken m_scanToken; // shared by the walk of the current root, its subtree scans and re-listings
 
     QString m_rootFolder;
+    QString m_activeAlbum;
+    bool m_albumPending = false; // the active album has not reported any photos yet
+    bool m_scanning = false;     // a full scan is streaming its batches
+    bool m_reconciling = false;  // the library was restored from a snapshot and is being compared with the file system
+    QSet<QString> m_relisting;     // directories with a re-listing in flight
+    QSet<QString> m_relistPending; // changed again while being re-listed
+    QString m_reconciledDirectory; // compared with the index by its first piece, the other pieces are skipped
+
+    int restartScans();
+    void scanDirectories(const QStringList &roots, int generation, bool fullScan);
+    void onDirectoriesScanned(const QVector<ScannedDirectory> &directories, int generation);
+    void onDirectoryTreeBuilt(const std::shared_ptr<DirectoryTree> &tree, int generation);
+    void onScanFinished(int generation);
+    void onDirectoriesChanged(const QStringList &changed);
+    void onDirectoriesListed(const QVector<WalkedDirectory> &listings, const QStringList &missing, int generation);
+    void applyChanges(const LibraryIndex::Changes &changes, int generation, bool scanAdded);
+    void showPhotos(const QVector<PhotoFile> &photos);
+    bool restoreSnapshot(const QString &folder);
 };
@@ -18,16 +18,21 @@
 
 #include "photomodel.h"
 #include "photoprovider.h"
+#include "metrics.h"
+#include "thumbnaildiskcache.h"
 #include <QUrl>
 #include <QDebug>
 #include <QDir>
+#include <algorithm>
+#include <limits>
 
 PhotoModel::PhotoModel(AppSettings *settings, QObject *parent)
-    : QAbstractListModel(parent), m_settings(settings), m_tempDir(new QTemporaryDir(ensureBasePath() + "/XXXXXX")), m_worker(m_tempDir->path(), m_settings->getValue("galleryTargetWidth").toInt(), this), m_exif(this)
+    : QAbstractListModel(parent), m_settings(settings), m_tempDir(new QTemporaryDir(ensureBasePath() + "/XXXXXX")), m_worker(m_settings->value<int>("galleryTargetWidth"), this), m_exif(this)
 {
     if (!m_tempDir->isValid()) qWarning() << "Failed to create temporary directory!";
 
-    m_providerPool.setMaxThreadCount(2);
+    setThumbnailBudget(m_settings->value<qint64>("thumbnailMemoryBudget") * 1024 * 1024);
+    m_worker.trimDiskCache(m_settings->value<qint64>("thumbnailDiskCache") * 1024 * 1024);
 
     connect(m_settings, &AppSettings::settingChanged,
             this, &PhotoModel::onSettingChanged);
@@ -42,14 +47,20 @@ PhotoModel::PhotoModel(AppSettings *settings, QObject *parent)
 PhotoModel::~PhotoModel() {
     qDeleteAll(m_providers);
     m_providers.clear();
+    qDeleteAll(m_removedProviders);
+    m_removedProviders.clear();
 
-    m_providerPool.clear();
-    m_providerPool.waitForDone();
+    m_providerTasks.clear();
+    m_providerTasks.waitForDone();
 }
 
 void PhotoModel::onSettingChanged(const QString &id, const QVariant &value) {
     if (id == QStringLiteral("galleryTargetWidth"))
         setThumbnailSize(value.toInt());
+    else if (id == QStringLiteral("thumbnailMemoryBudget"))
+        setThumbnailBudget(value.toLongLong() * 1024 * 1024);
+    else if (id == QStringLiteral("thumbnailDiskCache"))
+        m_worker.trimDiskCache(value.toLongLong() * 1024 * 1024);
 }
 
 int PhotoModel::rowCount(const QModelIndex &) const {
@@ -70,34 +81,32 @@ QVariant PhotoModel::data(const QModelIndex &index, int role) const {
 
     switch (role) {
     case FilePathRole:
-        return photo.filePath;
+        return m_photos.filePath(index.row());
 
     case ThumbPathRole:
-        if (!photo.thumbPath.isEmpty()) return photo.thumbPath;
+        if (photo.thumbnail) return thumbnailPath(index.row());
         return "";
 
     case FileSizeRole:
-        return photo.info.size();
-
-    case DateRole: {
-        QDateTime exifDate = m_exif.getData(photo.filePath).dateTaken;
-        if(exifDate.isValid()) return exifDate;
-        QDateTime birthTime = photo.info.birthTime();
-        if(birthTime.isValid()) return birthTime;
-        return photo.info.lastModified();
-    }
+        return photo.size;
+
+    case DateRole:
+        return photoDate(index.row(), m_exif.getData(m_photos.filePath(index.row())));
 
     case ExposureTimeRole:
-        return m_exif.getData(photo.filePath).exposureTime.value;
+        return m_exif.getData(m_photos.filePath(index.row())).exposureTime.value;
 
     case CameraModelRole:
-        return m_exif.getData(photo.filePath).cameraModel;
+        return m_exif.getData(m_photos.filePath(index.row())).cameraModel;
 
     case IsoRole:
-        return m_exif.getData(photo.filePath).iso;
+        return m_exif.getData(m_photos.filePath(index.row())).iso;
     
     case FocalLengthRole:
-        return m_exif.getData(photo.filePath).focalLength.value;
+        return m_exif.getData(m_photos.filePath(index.row())).focalLength.value;
+
+    case LensModelRole:
+        return m_exif.getData(m_photos.filePath(index.row())).lensModel;
 
     default:
         return {};
@@ -119,25 +128,21 @@ void PhotoModel::clear() {
     // Delete all existing providers
     qDeleteAll(m_providers);
     m_providers.clear();
+    qDeleteAll(m_removedProviders);
+    m_removedProviders.clear();
 
-    // Clear thumbnails and associated data
-    for (PhotoItem &photo : m_photos) {
-        if (!photo.thumbPath.isEmpty() && QFile::exists(photo.thumbPath)) {
-            if (!QFile::remove(photo.thumbPath)) {
-                qWarning() << "Failed to delete thumbnail:" << photo.thumbPath;
-            }
-        }
-    }
-
-    // Clear the model data and index map
+    // Clear the model data and path lookup, thumbnail files stay in the disk cache
     m_photos.clear();
-    m_indexMap.clear();
+    m_thumbnails.clear();
+    m_firstBatch = true;
 
     endResetModel();
 
-    // Clean worker queue and thread pool
-    m_providerPool.clear();
-    m_providerPool.waitForDone();
+    // Clean worker queues, work for the previous album stops at the next file
+    m_exif.cancelPending();
+    m_worker.cancelPending();
+    m_providerTasks.clear();
+    m_providerTasks.waitForDone();
 
     // Clean the temp directory
     if (m_tempDir && m_tempDir->isValid()) {
@@ -146,26 +151,117 @@ void PhotoModel::clear() {
     }
 }
 
-int PhotoModel::addPhoto(const QString &filePath) {
-    beginInsertRows(QModelIndex(), m_photos.size(), m_photos.size());
-    m_photos.append(PhotoItem(filePath));
-    int index = m_photos.size() - 1;
-    m_indexMap.insert(filePath, index);
+int PhotoModel::addPhotos(const QVector<PhotoFile> &files) {
+    Metrics::GuiScope guiTime;
+    const int first = m_photos.size();
+    if (files.isEmpty()) return first;
+
+    // Grow geometrically, an exact reserve per streamed batch would copy the whole model every time
+    const qsizetype needed = first + files.size();
+    m_photos.reserve(needed);
+
+    // One insert notification, index update and EXIF hand-off for the whole batch.
+    // Size and dates come from the scan, nothing is stat'ed on the GUI thread.
+    QStringList filePaths;
+    filePaths.reserve(files.size());
+    beginInsertRows(QModelIndex(), first, int(needed) - 1);
+    for (const PhotoFile &file : files) {
+        m_photos.append(file);
+        filePaths << file.filePath;
+    }
+    m_thumbnails.resize(m_photos.size());
     endInsertRows();
-    m_exif.requestData(index, filePath);
-    return index;
+
+    m_exif.requestData(first, filePaths);
+    return first;
+}
+
+void PhotoModel::removePhotos(const QStringList &filePaths) {
+    Metrics::GuiScope guiTime;
+    std::vector<int> rows;
+    rows.reserve(filePaths.size());
+    for (const QString &filePath : filePaths) {
+        m_exif.invalidate(filePath);
+        const int row = m_photos.find(filePath);
+        if (row >= 0) rows.push_back(row);
+    }
+    if (rows.empty()) return;
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    for (int row : rows)
+        clearThumbnail(row);
+
+    // Contiguous runs from the back, so rows in front keep their index
+    const int oldCount = m_photos.size();
+    for (size_t end = rows.size(); end > 0;) {
+        size_t begin = end - 1;
+        while (begin > 0 && rows[begin - 1] == rows[begin] - 1) --begin;
+        beginRemoveRows(QModelIndex(), rows[begin], rows[end - 1]);
+        m_photos.remove(rows[begin], rows[end - 1] - rows[begin] + 1);
+        endRemoveRows();
+        end = begin;
+    }
+
+    // Row indexed state follows the remaining rows
+    std::vector<int> newRows(oldCount, -1);
+    for (int row = 0, removed = 0; row < oldCount; ++row) {
+        if (removed < int(rows.size()) && rows[removed] == row) ++removed;
+        else newRows[row] = row - removed;
+    }
+    m_thumbnails.remap(newRows, m_photos.size());
+
+    // Providers follow their rows, the viewer may still show one of a removed photo until it moves on
+    QHash<int, PhotoProvider*> providers;
+    providers.reserve(m_providers.size());
+    for (auto it = m_providers.cbegin(); it != m_providers.cend(); ++it) {
+        const int row = newRows[it.key()];
+        if (row >= 0) providers.insert(row, it.value());
+        else if (it.value()->active()) m_removedProviders.append(it.value());
+        else delete it.value();
+    }
+    m_providers = std::move(providers);
+}
+
+void PhotoModel::invalidatePhotos(const QVector<PhotoFile> &files) {
+    bool requested = false;
+    for (const PhotoFile &file : files) {
+        // Metadata is cached by path, also for photos outside the current album
+        m_exif.invalidate(file.filePath);
+        const int row = m_photos.find(file.filePath);
+        if (row < 0) continue;
+
+        PhotoItem &photo = m_photos[row];
+        photo.size = file.size;
+        photo.modified = file.modified;
+        photo.created = file.created;
+        emit dataChanged(index(row), index(row), {FileSizeRole});
+        m_exif.requestData(row, file.filePath);
+        requested = true;
+
+        // Resident thumbnails are likely on screen, regenerate them right away
+        const bool resident = m_thumbnails.contains(row);
+        clearThumbnail(row);
+        if (resident) loadThumbnail(row);
+    }
+    if (requested) m_exif.startProcessing();
 }
 
 void PhotoModel::batchChangeFinished() {
-    emit loadingStarted({DateRole});
+    // Later batches fill in progressively without blocking the gallery again
+    if (m_firstBatch) emit loadingStarted({DateRole});
+    m_firstBatch = false;
     emit modelChanged();
     m_exif.startProcessing();
 }
 
 void PhotoModel::exifReady(int firstIndex, int lastIndex) {
-    if (isValidIndex(firstIndex) && isValidIndex(lastIndex))
-        emit dataChanged(this->index(firstIndex), this->index(lastIndex), {DateRole, ExposureTimeRole});
+    Metrics::GuiScope guiTime;
+    lastIndex = std::min(lastIndex, int(m_photos.size()) - 1); // rows may have been removed meanwhile
+    if (isValidIndex(firstIndex) && firstIndex <= lastIndex)
+        emit dataChanged(this->index(firstIndex), this->index(lastIndex), {DateRole, ExposureTimeRole, CameraModelRole, IsoRole, FocalLengthRole, LensModelRole});
     emit loadingFinished();
+    if (!m_exif.isProcessing()) emit metadataFinished();
 }
 
 void PhotoModel::setThumbnailSize(int targetShort) {
@@ -173,84 +269,163 @@ void PhotoModel::setThumbnailSize(int targetShort) {
 
     m_worker.setTargetSize(targetShort);
     // Lazy-recalculate existing thumbnails
-    for(int i = 0; i < m_photos.size(); ++i) {
-        const PhotoItem &photoItem = m_photos[i];
-        if(photoItem.requested && !photoItem.thumbPath.isEmpty()) {
-            m_worker.requestThumbnail(i, photoItem.filePath);
+    for(int i : m_thumbnails.rows()) {
+        if(m_photos[i].thumbnail) {
+            requestThumbnail(i);
         }
     }
 }
 
-void PhotoModel::loadThumbnail(int index) {
+void PhotoModel::requestThumbnail(int index, bool visible) {
+    const PhotoItem &photo = m_photos[index];
+    m_worker.requestThumbnail(index, m_photos.filePath(index), photo.size, photo.modified, visible);
+}
+
+void PhotoModel::cacheThumbnail(int index) {
+    if(!isValidIndex(index)) return;
+    const PhotoItem &photo = m_photos[index];
+    m_worker.cacheThumbnail(m_photos.filePath(index), photo.size, photo.modified);
+}
+
+void PhotoModel::recordThumbnailLookup(int index) {
+    if(isValidIndex(index)) m_thumbnails.recordLookup(m_photos[index].thumbnail != 0);
+}
+
+void PhotoModel::loadThumbnail(int index, bool visible) {
     if(!isValidIndex(index)) return;
     PhotoItem& photoItem = m_photos[index];
+    m_thumbnails.touch(index, estimatedThumbnailBytes());
     if(photoItem.requested) return;
-    m_worker.requestThumbnail(index, photoItem.filePath);
+    requestThumbnail(index, visible);
     photoItem.requested = true;
 }
 
 void PhotoModel::clearThumbnail(int index) {
     if(!isValidIndex(index)) return;
+    m_thumbnails.remove(index);
     PhotoItem& photoItem = m_photos[index];
-    if(photoItem.thumbPath.isEmpty()) return;
-    if(!QFile::exists(photoItem.thumbPath)) {
-        photoItem.thumbPath.clear();
-        photoItem.requested = false;
-        return;
-    }
-    if (!QFile::remove(photoItem.thumbPath))
-        qWarning() << "Failed to delete preloaded image:" << photoItem.thumbPath;
+    photoItem.requested = false;
+    if(!photoItem.thumbnail) return;
+    photoItem.thumbnail = 0; // the file stays in the disk cache, trimmed with it
+    emit dataChanged(this->index(index), this->index(index), {ThumbPathRole});
 }
 
-void PhotoModel::setThumbnail(int index, const QString &thumbPath) {
+void PhotoModel::setThumbnail(int index, const QString &filePath, qint64 modified, int targetShort, qint64 memoryBytes, qint64 diskBytes) {
+    // Rows may have moved or vanished while the thumbnail was generated
+    if (!isValidIndex(index) || m_photos.filePath(index) != filePath) index = m_photos.find(filePath);
     if (!isValidIndex(index)) return;
 
-    m_photos[index].thumbPath = thumbPath;
+    // Evicted or changed on disk while the thumbnail was generated
+    if (!m_photos[index].requested || m_photos[index].modified != modified) return;
+
+    m_photos[index].thumbnail = quint32(targetShort);
+    m_thumbnails.setBytes(index, memoryBytes, diskBytes);
     emit dataChanged(this->index(index), this->index(index), {ThumbPathRole});
 }
 
-int PhotoModel::getIndex(QString filePath) {
-    return m_indexMap.value(filePath, -1);
+QString PhotoModel::thumbnailPath(int index) const {
+    const PhotoItem &photo = m_photos[index];
+    if (!photo.thumbnail) return {};
+    return ThumbnailDiskCache::file(m_photos.filePath(index), photo.size, photo.modified, int(photo.thumbnail));
 }
 
-void PhotoModel::pruneProviders() {
-    QSet<int> keepIndices;
+qint64 PhotoModel::estimatedThumbnailBytes() const {
+    // Measured average at the current resolution, else a 4:3 ARGB32 thumbnail
+    const qint64 measured = m_thumbnails.averageMemoryBytes();
+    if (measured > 0) return measured;
+    const qint64 shortSide = m_worker.targetSize();
+    return shortSide * shortSide * 4 / 3 * 4;
+}
 
-    // Find all indices that should be kept
-    for (auto it = m_providers.cbegin(); it != m_providers.cend(); ++it) {
-        int idx = it.key();
-        PhotoProvider* provider = it.value();
+int PhotoModel::thumbnailCapacity() const {
+    const qint64 perThumbnail = std::max<qint64>(estimatedThumbnailBytes(), 1);
+    return int(std::min<qint64>(m_thumbnails.budget() / perThumbnail, std::numeric_limits<int>::max()));
+}
 
-        if(provider->active()) {
-            keepIndices << idx << idx - 1 << idx - 2 << idx + 1 << idx + 2;  //Keep provider and its neighbors
-        }
-        else if(provider->waiting()) keepIndices << idx; //Keep if provider is waiting for a Image-Preload to ensure proper preload deletion later
-    }
+QVariantMap PhotoModel::thumbnailMetrics() const {
+    return {
+        { "residentCount", m_thumbnails.size() },
+        { "residentBytes", qint64(m_thumbnails.memoryBytes()) },
+        { "diskBytes", qint64(m_thumbnails.diskBytes()) },
+        { "budgetBytes", qint64(m_thumbnails.budget()) },
+        { "hitRate", m_thumbnails.hitRate() },
+        { "lookups", qint64(m_thumbnails.lookups()) }
+    };
+}
 
-    // Remove all others
-    QList<int> toRemove;
-    for (auto it = m_providers.cbegin(); it != m_providers.cend(); ++it) {
-        if (!keepIndices.contains(it.key())) {
-            toRemove << it.key();
+QVariantMap PhotoModel::providerMetrics() const {
+    qint64 bytes = 0;
+    for (const PhotoProvider *provider : m_providers)
+        bytes += provider->decodedBytes();
+    return {
+        { "count", int(m_providers.size()) },
+        { "bytes", bytes }
+    };
+}
+
+QVariantMap PhotoModel::memoryMetrics() const {
+    const qint64 bytes = m_photos.memoryBytes();
+    return {
+        { "photos", m_photos.size() },
+        { "bytes", bytes },
+        { "bytesPerPhoto", m_photos.size() > 0 ? double(bytes) / m_photos.size() : 0.0 }
+    };
+}
+
+QHash<QString, ExifData> PhotoModel::metadata() const {
+    QStringList filePaths;
+    filePaths.reserve(m_photos.size());
+    for (int row = 0; row < m_photos.size(); ++row)
+        filePaths << m_photos.filePath(row);
+    return m_exif.knownData(filePaths);
+}
+
+ExifData PhotoModel::exifData(int index) const {
+    if (!isValidIndex(index)) return {};
+    return m_exif.getData(m_photos.filePath(index));
+}
+
+QDateTime PhotoModel::photoDate(int index, const ExifData &exif) const {
+    if (!isValidIndex(index)) return {};
+    if(exif.dateTaken.isValid()) return exif.dateTaken;
+    const PhotoItem &photo = m_photos[index];
+    if(photo.created > 0) return QDateTime::fromMSecsSinceEpoch(photo.created);
+    return QDateTime::fromMSecsSinceEpoch(photo.modified);
+}
+
+int PhotoModel::getIndex(QString filePath) {
+    return m_photos.find(filePath);
+}
+
+void PhotoModel::pruneProviders(const QSet<int> &keep) {
+    for (auto it = m_providers.begin(); it != m_providers.end();) {
+        //Keep if provider is waiting for a Image-Preload to ensure proper preload deletion later
+        if (keep.contains(it.key()) || it.value()->active() || it.value()->waiting()) ++it;
+        else {
+            delete it.value();
+            it = m_providers.erase(it);
         }
     }
+}
 
-    for (int idx : toRemove) {
-        delete m_providers.take(idx);
-    }
+QVector<int> PhotoModel::activeProviders() const {
+    QVector<int> rows;
+    for (auto it = m_providers.cbegin(); it != m_providers.cend(); ++it)
+        if (it.value()->active()) rows << it.key();
+    return rows;
 }
 
-PhotoProvider* PhotoModel::getProvider(int index, int viewIndex) {
+PhotoProvider* PhotoModel::getProvider(int index) {
     if (!isValidIndex(index)) return nullptr;
 
     PhotoProvider* provider = nullptr;
 
-    if (m_providers.contains(viewIndex)) {
-        provider = m_providers.value(viewIndex);
+    if (m_providers.contains(index)) {
+        provider = m_providers.value(index);
     } else {
-        PhotoItem photo = m_photos[index];
-        provider = new PhotoProvider(photo.filePath, photo.thumbPath, photo.info, m_exif.getData(photo.filePath), &m_providerPool, m_tempDir->path(), this);
-        m_providers.insert(viewIndex, provider);
+        const QString filePath = m_photos.filePath(index);
+        provider = new PhotoProvider(filePath, thumbnailPath(index), QFileInfo(filePath), m_exif.getData(filePath), &m_providerTasks, m_tempDir->path(), this);
+        m_providers.insert(index, provider);
     }
 
     return provider;
@@ -18,34 +18,25 @@
 
 #pragma once
 #include <QAbstractListModel>
+#include <QSet>
 #include <QVector>
 #include <QString>
-#include <QThreadPool>
 #include <QTemporaryDir>
 #include "appsettings.h"
 #include "structs.h"
 #include "exifregistry.h"
 #include "thumbnailworker.h"
+#include "thumbnailcache.h"
+#include "photostore.h"
+#include "taskscheduler.h"
 
 class ThumbnailWorker;
 class PhotoProvider;
 
-struct PhotoItem {
-    QString filePath;
-    QString thumbPath;
-    bool requested = false; // has thumbnail generation been requested yet
-    QFileInfo info;
-    ExifData exif;
-
-    PhotoItem() = default;
-    PhotoItem(const QString &path, const QString &thumb = QString(), bool req = false)
-        : filePath(path), thumbPath(thumb), requested(req), info(path) {}
-};
-
 class PhotoModel : public QAbstractListModel {
     Q_OBJECT
 public:
-    enum Roles { FilePathRole = Qt::UserRole + 1, ThumbPathRole, FileSizeRole, DateRole, ExposureTimeRole, CameraModelRole, IsoRole, FocalLengthRole };
+    enum Roles { FilePathRole = Qt::UserRole + 1, ThumbPathRole, FileSizeRole, DateRole, ExposureTimeRole, CameraModelRole, IsoRole, FocalLengthRole, LensModelRole };
 
     explicit PhotoModel(AppSettings *settings, QObject *parent = nullptr);
     ~PhotoModel();
@@ -64,33 +55,66 @@ public:
 
     void clear();
 
-    int addPhoto(const QString &filePath);
+    int addPhotos(const QVector<PhotoFile> &files);
+    void removePhotos(const QStringList &filePaths);
+    void invalidatePhotos(const QVector<PhotoFile> &files); // reload metadata and thumbnails of changed files
     void batchChangeFinished();
     void exifReady(int firstIndex, int lastIndex);
     void setThumbnailSize(int targetShort);
-    void loadThumbnail(int index);
+    void loadThumbnail(int index, bool visible = false);
+    void recordThumbnailLookup(int index); // as the row comes into view, for the hit rate
+    void cacheThumbnail(int index); // into the disk cache without becoming resident, for indexing
     void clearThumbnail(int index);
-    void setThumbnail(int index, const QString &thumbPath);
+    void setThumbnail(int index, const QString &filePath, qint64 modified, int targetShort, qint64 memoryBytes, qint64 diskBytes);
+    std::vector<int> residentThumbnails() const { return m_thumbnails.rows(); }
+
+    // Byte budget shared by decoded thumbnails and their files
+    void setThumbnailBudget(qint64 bytes) { m_thumbnails.setBudget(bytes); }
+    int thumbnailCapacity() const;
+    bool thumbnailsOverBudget() const { return m_thumbnails.overBudget(); }
+    bool loadingMetadata() const { return m_exif.isProcessing(); }
+    int leastRecentThumbnail() const { return m_thumbnails.leastRecent(); }
+    int moreRecentThumbnail(int index) const { return m_thumbnails.moreRecent(index); }
+    QVariantMap thumbnailMetrics() const;
+    QVariantMap memoryMetrics() const; // bytes held by the photo rows themselves
+    QVariantMap providerMetrics() const; // open full-size photos and their decoded bytes
+
+    // Session snapshot, see LibrarySnapshot
+    QString filePath(int index) const { return isValidIndex(index) ? m_photos.filePath(index) : QString(); }
+    QString thumbnailFile(int index) const { return isValidIndex(index) ? thumbnailPath(index) : QString(); }
+    QHash<QString, ExifData> metadata() const;
+    void restoreMetadata(const QHash<QString, ExifData> &metadata) { m_exif.restore(metadata); }
+
+    ExifData exifData(int index) const;
+    QDateTime photoDate(int index, const ExifData &exif) const;
 
     int getIndex(QString filePath);
-    PhotoProvider* getProvider(int index, int viewIndex);
-    void pruneProviders();
+    PhotoProvider* getProvider(int index);
+    QVector<int> activeProviders() const; // rows
+    void pruneProviders(const QSet<int> &keep); // besides active and waiting ones
 
 signals:
     void modelChanged();
     void loadingStarted(const QList<int> &roles);
     void loadingFinished();
+    void metadataFinished(); // every requested batch of metadata has arrived
 
 private:
     AppSettings* m_settings;
     QScopedPointer<QTemporaryDir> m_tempDir;
     ThumbnailWorker m_worker;
     ExifRegistry m_exif;
-    QThreadPool m_providerPool;
-    QVector<PhotoItem> m_photos;
-    QHash<QString, int> m_indexMap;
+    TaskGroup m_providerTasks { Metrics::ProviderPool };
+    PhotoStore m_photos;
+    ThumbnailCache m_thumbnails;
+
+    bool m_firstBatch = true; // the first batch of an album blocks the gallery until its metadata is ready
 
-    QHash<int, PhotoProvider*> m_providers;
+    QHash<int, PhotoProvider*> m_providers; // by row
+    QVector<PhotoProvider*> m_removedProviders; // still active when their photo was removed
     bool isValidIndex(QModelIndex index) const;
     bool isValidIndex(int index) const;
+    qint64 estimatedThumbnailBytes() const;
+    QString thumbnailPath(int index) const; // the disk cache file the row shows, empty if there is none
+    void requestThumbnail(int index, bool visible = false);
 };
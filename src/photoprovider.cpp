@@ -17,8 +17,8 @@
 */
 
 #include "photoprovider.h"
-#include <QtConcurrent>
-#include <QFuture>
+#include "tracing.h"
+#include "metrics.h"
 #include <QImageReader>
 #include <QMetaObject>
 #include <QDir>
@@ -26,8 +26,8 @@
 #include <QPointer>
 #include <QUuid>
 
-PhotoProvider::PhotoProvider(const QString &filePath, const QString &thumbPath, const QFileInfo &info, const ExifData &exif, QThreadPool *threadPool, const QString &tempPath, QObject *parent)
-    : QObject(parent), m_filePath(filePath), m_thumbPath(thumbPath), m_info(info), m_exif(exif), m_threadPool(threadPool), m_tempPath(tempPath), m_active(false)
+PhotoProvider::PhotoProvider(const QString &filePath, const QString &thumbPath, const QFileInfo &info, const ExifData &exif, TaskGroup *tasks, const QString &tempPath, QObject *parent)
+    : QObject(parent), m_filePath(filePath), m_thumbPath(thumbPath), m_info(info), m_exif(exif), m_tasks(tasks), m_tempPath(tempPath), m_active(false)
 {
     emit filePathChanged();
     emit thumbPathChanged();
@@ -46,12 +46,18 @@ void PhotoProvider::startLoading() {
     QPointer<PhotoProvider> that(this); // safe weak reference
 
     m_waiting = true;
-    m_future = QtConcurrent::run(m_threadPool, [that]() {
+    m_tasks->run(TaskScheduler::Interactive, TaskScheduler::CpuLane, [that]() {
         if (!that) return;
+        LYSA_TRACE_SCOPE("photo", "PhotoProvider::load");
 
-        QImageReader reader(that->m_filePath);
-        reader.setAutoTransform(true);
-        QImage img = reader.read();
+        QImage img;
+        {
+            LYSA_TRACE_SCOPE("photo", "QImageReader::read");
+            Metrics::LatencyScope latency(Metrics::PhotoDecode);
+            QImageReader reader(that->m_filePath);
+            reader.setAutoTransform(true);
+            img = reader.read();
+        }
 
         if (img.isNull()) {
             qWarning() << "Failed to load image:" << that->m_filePath;
@@ -74,14 +80,17 @@ void PhotoProvider::startLoading() {
 
         QString imgPath = tempDir.filePath("img_" + QUuid::createUuid().toString(QUuid::Id128) + ".jpg");
 
+        LYSA_TRACE_SCOPE("photo", "QImage::save");
         if (!img.save(imgPath, "JPG")) {
             qWarning() << "Failed to save preloaded image:" << imgPath;
             return;
         }
 
-        QMetaObject::invokeMethod(that, [that, imgPath]() {
+        const qint64 decodedBytes = img.sizeInBytes();
+        QMetaObject::invokeMethod(that, [that, imgPath, decodedBytes]() {
             if (that) {
                 that->m_loadedPath = imgPath;
+                that->m_decodedBytes = decodedBytes;
                 that->m_waiting = false;
                 emit that->imageReady(imgPath);
             }
@@ -20,8 +20,8 @@
 #include <QObject>
 #include <QString>
 #include <QFileInfo>
-#include <QFuture>
 #include "structs.h"
+#include "taskscheduler.h"
 
 class PhotoProvider : public QObject {
     Q_OBJECT
@@ -32,13 +32,14 @@ class PhotoProvider : public QObject {
     Q_PROPERTY(ExifData exifData READ exifData NOTIFY exifDataChanged)
 
 public:
-    explicit PhotoProvider(const QString &filePath, const QString &thumbPath, const QFileInfo &info, const ExifData &exif, QThreadPool *threadPool, const QString &tempPath, QObject *parent = nullptr);
+    explicit PhotoProvider(const QString &filePath, const QString &thumbPath, const QFileInfo &info, const ExifData &exif, TaskGroup *tasks, const QString &tempPath, QObject *parent = nullptr);
     ~PhotoProvider();
 
     bool active() const { return m_active; }
     Q_INVOKABLE void setActive(bool value) { m_active = value; }
 
     bool waiting() const { return m_waiting; }
+    qint64 decodedBytes() const { return m_decodedBytes; } // of the full-size image the view decodes again
 
     QString loadedPath() const { return m_loadedPath; }
     QString filePath() const { return m_filePath; }
@@ -56,15 +57,15 @@ signals:
     void exifDataChanged();
 
 private:
-    QThreadPool *m_threadPool = nullptr;
+    TaskGroup *m_tasks = nullptr;
     QString m_tempPath;
     bool m_active;
     bool m_waiting = false;
+    qint64 m_decodedBytes = 0;
     QString m_filePath;
     QString m_loadedPath;
     QString m_thumbPath;
     QFileInfo m_info;
     ExifData m_exif;
     void startLoading();
-    QFuture<void> m_future;
 };
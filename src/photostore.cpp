@@ -0,0 +1,154 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "photostore.h"
+#include <algorithm>
+
+void PhotoStore::clear() {
+    m_items.clear();
+    m_directories.clear();
+    m_directoryIds.clear();
+    m_lastDirectory = 0;
+    m_names.clear();
+    m_deadNames = 0;
+    m_slots.clear();
+}
+
+void PhotoStore::reserve(qsizetype count) {
+    // Geometric growth, streamed batches would otherwise reallocate for every batch
+    if (qsizetype(m_items.capacity()) < count) m_items.reserve(std::max<size_t>(count, m_items.capacity() * 2));
+}
+
+qsizetype PhotoStore::directoryLength(const QString &filePath) {
+    // The root keeps its slash, "/a.jpg" lives in "/"
+    const qsizetype slash = filePath.lastIndexOf(QLatin1Char('/'));
+    return slash == 0 ? 1 : std::max<qsizetype>(slash, 0);
+}
+
+void PhotoStore::append(const PhotoFile &file) {
+    const qsizetype length = directoryLength(file.filePath);
+    const QStringView directory = QStringView(file.filePath).left(length);
+    const QStringView fileName = QStringView(file.filePath).mid(length < file.filePath.size() && file.filePath.at(length) == QLatin1Char('/') ? length + 1 : length);
+
+    quint32 directoryId = m_lastDirectory;
+    if (m_directories.isEmpty() || m_directories.at(m_lastDirectory) != directory) {
+        const QString path = directory.toString();
+        auto it = m_directoryIds.constFind(path);
+        if (it != m_directoryIds.cend()) directoryId = it.value();
+        else {
+            directoryId = quint32(m_directories.size());
+            m_directories << path;
+            m_directoryIds.insert(path, directoryId);
+        }
+        m_lastDirectory = directoryId;
+    }
+
+    PhotoItem item;
+    item.directory = directoryId;
+    item.nameOffset = quint32(m_names.size());
+    item.nameLength = quint16(fileName.size());
+    item.size = file.size;
+    item.modified = file.modified;
+    item.created = file.created;
+    m_names.insert(m_names.end(), fileName.utf16(), fileName.utf16() + fileName.size());
+    m_items.push_back(item);
+
+    // Load factor of at most one half
+    if (m_items.size() * 2 > m_slots.size()) rehash();
+    else insertSlot(int(m_items.size()) - 1);
+}
+
+void PhotoStore::remove(int first, int count) {
+    if (first < 0 || count <= 0 || first + count > size()) return;
+    for (int row = first; row < first + count; ++row)
+        m_deadNames += m_items[row].nameLength;
+    m_items.erase(m_items.begin() + first, m_items.begin() + first + count);
+
+    if (m_deadNames * 2 > qsizetype(m_names.size())) compactNames();
+    rehash();
+}
+
+QString PhotoStore::filePath(int row) const {
+    const PhotoItem &item = m_items[row];
+    const QString &directory = m_directories.at(item.directory);
+    const QStringView fileName = name(item);
+
+    QString path;
+    path.reserve(directory.size() + fileName.size() + 1);
+    path += directory;
+    if (!directory.isEmpty() && !directory.endsWith(QLatin1Char('/'))) path += QLatin1Char('/');
+    path += fileName;
+    return path;
+}
+
+int PhotoStore::find(const QString &filePath) const {
+    if (m_slots.empty()) return -1;
+
+    const qsizetype length = directoryLength(filePath);
+    auto directory = m_directoryIds.constFind(filePath.left(length));
+    if (directory == m_directoryIds.cend()) return -1;
+    const QStringView fileName = QStringView(filePath).mid(length < filePath.size() && filePath.at(length) == QLatin1Char('/') ? length + 1 : length);
+
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = slotFor(directory.value(), fileName);; slot = (slot + 1) & mask) {
+        const quint32 entry = m_slots[slot];
+        if (entry == 0) return -1;
+        const PhotoItem &item = m_items[entry - 1];
+        if (item.directory == directory.value() && name(item) == fileName) return int(entry - 1);
+    }
+}
+
+qint64 PhotoStore::memoryBytes() const {
+    qint64 bytes = qint64(m_items.capacity() * sizeof(PhotoItem))
+                 + qint64(m_names.capacity() * sizeof(char16_t))
+                 + qint64(m_slots.capacity() * sizeof(quint32));
+
+    // Directory strings are shared between the table and the hash, count them once
+    for (const QString &directory : m_directories)
+        bytes += qint64(sizeof(QString)) * 2 + directory.capacity() * qint64(sizeof(QChar)) + qint64(sizeof(quint32));
+    return bytes;
+}
+
+void PhotoStore::insertSlot(int row) {
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = slotFor(m_items[row].directory, name(m_items[row]));
+    while (m_slots[slot] != 0)
+        slot = (slot + 1) & mask;
+    m_slots[slot] = quint32(row) + 1;
+}
+
+void PhotoStore::rehash() {
+    size_t slots = 16;
+    while (slots < m_items.size() * 2)
+        slots *= 2;
+    m_slots.assign(slots, 0);
+    for (int row = 0; row < size(); ++row)
+        insertSlot(row);
+}
+
+void PhotoStore::compactNames() {
+    std::vector<char16_t> names;
+    names.reserve(m_names.size() - size_t(m_deadNames));
+    for (PhotoItem &item : m_items) {
+        const quint32 offset = quint32(names.size());
+        names.insert(names.end(), m_names.begin() + item.nameOffset, m_names.begin() + item.nameOffset + item.nameLength);
+        item.nameOffset = offset;
+    }
+    m_names.swap(names);
+    m_deadNames = 0;
+}
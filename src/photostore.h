@@ -0,0 +1,73 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <vector>
+#include "structs.h"
+
+struct PhotoItem {
+    quint32 directory = 0;  // into the directory table
+    quint32 nameOffset = 0; // into the name arena
+    quint16 nameLength = 0;
+    bool requested = false; // has thumbnail generation been requested yet
+    quint32 thumbnail = 0;  // shorter side of the thumbnail in the disk cache, 0 if there is none
+    qint64 size = 0;
+    qint64 modified = 0;    // msecs since epoch
+    qint64 created = 0;     // msecs since epoch, 0 if unknown
+};
+
+// Compact photo rows: paths are split into a shared directory table and a UTF-16 name arena,
+// rows refer to them with 32-bit ids and keep file metadata inline. Lookup by path goes through
+// an open addressing table of row ids instead of a hash keyed by full path copies.
+class PhotoStore {
+public:
+    void clear();
+    void reserve(qsizetype count);
+    int size() const { return int(m_items.size()); }
+
+    void append(const PhotoFile &file);
+    void remove(int first, int count);
+
+    PhotoItem& operator[](int row) { return m_items[row]; }
+    const PhotoItem& operator[](int row) const { return m_items[row]; }
+
+    QString filePath(int row) const;
+    int find(const QString &filePath) const; // -1 if unknown
+
+    qint64 memoryBytes() const;
+
+private:
+    std::vector<PhotoItem> m_items;
+    QStringList m_directories;
+    QHash<QString, quint32> m_directoryIds;
+    quint32 m_lastDirectory = 0;  // files arrive grouped by directory
+    std::vector<char16_t> m_names;
+    qsizetype m_deadNames = 0;    // arena characters of removed rows
+    std::vector<quint32> m_slots; // row + 1, 0 marks an empty slot
+
+    QStringView name(const PhotoItem &item) const { return QStringView(m_names.data() + item.nameOffset, item.nameLength); }
+    size_t slotFor(quint32 directory, QStringView name) const { return qHash(name, directory) & (m_slots.size() - 1); }
+    static qsizetype directoryLength(const QString &filePath);
+    void insertSlot(int row);
+    void rehash();
+    void compactNames();
+};
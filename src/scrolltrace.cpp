@@ -0,0 +1,69 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scrolltrace.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+void ScrollTrace::record(int firstIndex, int lastIndex, int itemsPerRow, int preloadDirection) {
+    if (!m_clock.isValid()) m_clock.start();
+    events.append({ m_clock.elapsed(), firstIndex, lastIndex, itemsPerRow, preloadDirection });
+}
+
+bool ScrollTrace::load(const QString &filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not read scroll trace:" << filePath << file.errorString();
+        return false;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Invalid scroll trace:" << filePath << error.errorString();
+        return false;
+    }
+
+    events.clear();
+    const QJsonArray array = document.object().value("events").toArray();
+    events.reserve(array.size());
+    for (const QJsonValue &value : array) {
+        const QJsonArray event = value.toArray();
+        if (event.size() < 5) continue;
+        events.append({ qint64(event[0].toDouble()), event[1].toInt(), event[2].toInt(), event[3].toInt(), event[4].toInt() });
+    }
+    return true;
+}
+
+bool ScrollTrace::save(const QString &filePath) const {
+    QJsonArray array;
+    for (const ScrollEvent &event : events)
+        array.append(QJsonArray { qint64(event.msecs), event.firstIndex, event.lastIndex, event.itemsPerRow, event.preloadDirection });
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write scroll trace:" << filePath << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(QJsonObject { { "events", array } }).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
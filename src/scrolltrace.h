@@ -0,0 +1,46 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+// The requests the gallery view makes while it is scrolled or zoomed, one per GalleryModel::loadThumbnails call.
+// Recorded from a live session with --record-scroll, replayed by lysa-scrollbench.
+struct ScrollEvent {
+    qint64 msecs = 0; // since the first event
+    int firstIndex = 0;
+    int lastIndex = 0;
+    int itemsPerRow = 1;
+    int preloadDirection = 0;
+};
+
+class ScrollTrace {
+public:
+    QVector<ScrollEvent> events;
+
+    void record(int firstIndex, int lastIndex, int itemsPerRow, int preloadDirection);
+
+    // JSON, {"events": [[msecs, first, last, itemsPerRow, direction], ...]}
+    bool load(const QString &filePath);
+    bool save(const QString &filePath) const;
+
+private:
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,78 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+#include "sortkeyindex.h"
+#include <algorithm>
+#include <numeric>
+
+void SortKeyIndex::reset(Kind kind, int rows) {
+    m_kind = kind;
+    m_keys.assign(size_t(rows), 0.0);
+    m_distinctIds.clear();
+    m_distinctKeys.clear();
+    m_ranks.clear();
+    m_rowIds.clear();
+    m_ranksDirty = false;
+    if (kind == Number) return;
+
+    m_rowIds.assign(size_t(rows), 0);
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+    m_collator.setNumericMode(kind == NaturalText);
+}
+
+void SortKeyIndex::insertRows(int first, int count) {
+    m_keys.insert(m_keys.begin() + first, size_t(count), 0.0);
+    if (m_kind != Number) m_rowIds.insert(m_rowIds.begin() + first, size_t(count), 0);
+}
+
+void SortKeyIndex::removeRows(int first, int count) {
+    m_keys.erase(m_keys.begin() + first, m_keys.begin() + first + count);
+    if (m_kind != Number) m_rowIds.erase(m_rowIds.begin() + first, m_rowIds.begin() + first + count);
+}
+
+void SortKeyIndex::setText(int row, const QString &value) {
+    auto it = m_distinctIds.constFind(value);
+    if (it == m_distinctIds.cend()) {
+        it = m_distinctIds.insert(value, uint32_t(m_distinctKeys.size()));
+        m_distinctKeys.push_back(m_collator.sortKey(value));
+        m_ranksDirty = true;
+    }
+    m_rowIds[size_t(row)] = it.value();
+    if (!m_ranksDirty) m_keys[size_t(row)] = m_ranks[it.value()];
+}
+
+void SortKeyIndex::updateRanks() {
+    if (!m_ranksDirty) return;
+    m_ranksDirty = false;
+
+    // One collation per distinct value, rows only look up the rank of theirs
+    std::vector<uint32_t> order(m_distinctKeys.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return m_distinctKeys[a].compare(m_distinctKeys[b]) < 0;
+    });
+
+    m_ranks.assign(order.size(), 0);
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && m_distinctKeys[order[i - 1]].compare(m_distinctKeys[order[i]]) != 0) ++rank;
+        m_ranks[order[i]] = rank;
+    }
+
+    for (size_t row = 0; row < m_keys.size(); ++row)
+        m_keys[row] = m_ranks[m_rowIds[row]];
+}
@@ -0,0 +1,53 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <QCollator>
+#include <QHash>
+#include <QString>
+#include <vector>
+#include <cstdint>
+
+// Sort key per source row, so comparing two rows is comparing two numbers instead of fetching role data.
+// Numbers are kept as they are, strings are replaced by the collation rank of their distinct value.
+class SortKeyIndex {
+public:
+    enum Kind { Number, Text, NaturalText }; // natural text puts "IMG_2" before "IMG_10"
+
+    void reset(Kind kind, int rows);
+    void insertRows(int first, int count); // keys are set afterwards
+    void removeRows(int first, int count);
+
+    void setNumber(int row, double value) { m_keys[size_t(row)] = value; }
+    void setText(int row, const QString &value);
+    void updateRanks(); // after setText(), only collates again when new distinct strings arrived
+
+    int rowCount() const { return int(m_keys.size()); }
+    bool lessThan(int leftRow, int rightRow) const { return m_keys[size_t(leftRow)] < m_keys[size_t(rightRow)]; }
+
+private:
+    Kind m_kind = Number;
+    std::vector<double> m_keys;
+
+    // Text, distinct values are interned: camera models repeat for almost every row
+    QCollator m_collator;
+    QHash<QString, uint32_t> m_distinctIds;
+    std::vector<QCollatorSortKey> m_distinctKeys; // by id
+    std::vector<uint32_t> m_ranks;                // by id, ties share a rank
+    std::vector<uint32_t> m_rowIds;
+    bool m_ranksDirty = false;
+};
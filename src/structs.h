@@ -126,6 +126,14 @@ struct ExifData {
         double gpsAltitude;
 };
 
+// File metadata gathered off the GUI thread by the library scan
+struct PhotoFile {
+    QString filePath;
+    qint64 size = 0;
+    qint64 modified = 0; // msecs since epoch
+    qint64 created = 0;  // msecs since epoch, 0 where the file system does not record it
+};
+
 struct FileData {
     Q_GADGET
     Q_PROPERTY(QString fileName MEMBER fileName CONSTANT)
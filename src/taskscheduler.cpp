@@ -0,0 +1,194 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "taskscheduler.h"
+#include <QDebug>
+#include <QString>
+#include <QThread>
+#include <algorithm>
+
+//----- TaskScheduler -----//
+
+TaskScheduler::TaskScheduler(int cpuThreads, int ioThreads) {
+    const int cores = std::max(QThread::idealThreadCount(), 1);
+    m_lanes[CpuLane].count = cpuThreads > 0 ? cpuThreads : cores;
+    m_lanes[IoLane].first = m_lanes[CpuLane].count;
+    m_lanes[IoLane].count = ioThreads > 0 ? ioThreads : std::clamp(cores / 2, 2, 4);
+    m_lanes[CoordinatorLane].first = m_lanes[IoLane].first + m_lanes[IoLane].count;
+    m_lanes[CoordinatorLane].count = 2; // a full scan and a subtree scan side by side
+
+    for (int lane = 0; lane < LaneCount; ++lane) {
+        for (int i = 0; i < m_lanes[lane].count; ++i)
+            m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (int lane = 0; lane < LaneCount; ++lane) {
+        for (int i = 0; i < m_lanes[lane].count; ++i)
+            m_threads.emplace_back(&TaskScheduler::work, this, Lane(lane), m_lanes[lane].first + i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    m_stop = true;
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+    }
+    for (std::condition_variable &workAvailable : m_workAvailable)
+        workAvailable.notify_all();
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::submit(TaskGroup *group, Priority priority, Lane lane, std::function<void()> task) {
+    const LaneRange &range = m_lanes[lane];
+    const int id = range.first + int(m_nextWorker[lane].fetch_add(1, std::memory_order_relaxed) % unsigned(range.count));
+    {
+        Worker &worker = *m_workers[id];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[priority].push_back({ group, std::move(task) });
+        ++m_queued[lane][priority];
+        ++m_laneQueued[lane];
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+    }
+    m_workAvailable[lane].notify_one();
+}
+
+int TaskScheduler::remove(TaskGroup *group) {
+    int removed = 0;
+    for (int lane = 0; lane < LaneCount; ++lane) {
+        const LaneRange &range = m_lanes[lane];
+        for (int id = range.first; id < range.first + range.count; ++id) {
+            Worker &worker = *m_workers[id];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            for (int priority = 0; priority < PriorityCount; ++priority) {
+                std::deque<Task> &queue = worker.queues[priority];
+                const auto end = std::remove_if(queue.begin(), queue.end(), [group](const Task &task) { return task.group == group; });
+                const int count = int(std::distance(end, queue.end()));
+                queue.erase(end, queue.end());
+                m_queued[lane][priority] -= count;
+                m_laneQueued[lane] -= count;
+                removed += count;
+            }
+        }
+    }
+    return removed;
+}
+
+// Own deque from the front (submission order), others from the back (what their owner would reach last)
+bool TaskScheduler::take(Lane lane, int id, Task &task) {
+    const LaneRange &range = m_lanes[lane];
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        if (m_queued[lane][priority].load(std::memory_order_relaxed) <= 0) continue;
+        for (int i = 0; i < range.count; ++i) {
+            const int victim = range.first + (id - range.first + i) % range.count;
+            Worker &worker = *m_workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<Task> &queue = worker.queues[priority];
+            if (queue.empty()) continue;
+            if (victim == id) {
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            else {
+                task = std::move(queue.back());
+                queue.pop_back();
+            }
+            --m_queued[lane][priority];
+            --m_laneQueued[lane];
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::work(Lane lane, int id) {
+    static const char *names[LaneCount] = { "CPU worker", "I/O worker", "Coordinator" };
+    QThread::currentThread()->setObjectName(QString::fromLatin1(names[lane]));
+
+    while (!m_stop) {
+        Task task;
+        if (!take(lane, id, task)) {
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            m_workAvailable[lane].wait(lock, [this, lane] { return m_stop || m_laneQueued[lane].load() > 0; });
+            continue;
+        }
+
+        Metrics::started(task.group->m_pool);
+        ++m_busy[lane];
+        try {
+            task.run();
+        }
+        catch (const std::exception &e) {
+            qWarning() << "Background task failed:" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Background task failed";
+        }
+        --m_busy[lane];
+        Metrics::finished(task.group->m_pool);
+        task.group->finished(1);
+    }
+}
+
+
+//----- TaskGroup -----//
+
+TaskGroup::TaskGroup(Metrics::Pool pool, TaskScheduler &scheduler) : m_pool(pool), m_scheduler(scheduler) {}
+
+TaskGroup::~TaskGroup() {
+    clear();
+    waitForDone();
+}
+
+void TaskGroup::run(TaskScheduler::Priority priority, TaskScheduler::Lane lane, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_outstanding;
+    }
+    Metrics::queued(m_pool);
+    m_scheduler.submit(this, priority, lane, std::move(task));
+}
+
+void TaskGroup::clear() {
+    const int removed = m_scheduler.remove(this);
+    if (removed == 0) return;
+    Metrics::dropped(m_pool, removed);
+    finished(removed);
+}
+
+void TaskGroup::waitForDone() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_outstanding == 0; });
+}
+
+int TaskGroup::outstanding() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_outstanding;
+}
+
+void TaskGroup::finished(int tasks) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_outstanding -= tasks;
+    if (m_outstanding == 0) m_done.notify_all();
+}
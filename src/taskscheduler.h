@@ -0,0 +1,109 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+
+class TaskGroup;
+
+// One set of worker threads for all background work of the process, instead of a thread pool per subsystem.
+// Tasks run by priority class in one of three lanes: the CPU lane (decoding, scaling) has a thread per core, the
+// I/O lane (directory listings, metadata reads) a few threads that mostly wait on the disk. The coordinator lane
+// runs tasks that wait for tasks of the other lanes, like a directory walk reporting its listings in order, so
+// they never hold a worker the tasks they wait for need. Each worker has its own deques, idle workers steal from
+// the others of their lane, higher priorities first.
+class TaskScheduler {
+public:
+    enum Priority { Interactive, Visible, Metadata, Prefetch, Background, PriorityCount };
+    enum Lane { CpuLane, IoLane, CoordinatorLane, LaneCount };
+
+    explicit TaskScheduler(int cpuThreads = 0, int ioThreads = 0); // 0: one per core, and up to 4; always 2 coordinators
+    ~TaskScheduler(); // drops queued tasks and joins the workers
+
+    static TaskScheduler& instance();
+
+    int threadCount(Lane lane) const { return m_lanes[lane].count; }
+    int busyThreads(Lane lane) const { return m_busy[lane].load(std::memory_order_relaxed); }
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        TaskGroup *group;
+        std::function<void()> run;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[PriorityCount];
+    };
+
+    struct LaneRange {
+        int first = 0;
+        int count = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    LaneRange m_lanes[LaneCount];
+    std::atomic<int> m_queued[LaneCount][PriorityCount] {}; // tasks waiting in any deque of the lane
+    std::atomic<int> m_laneQueued[LaneCount] {};
+    std::atomic<int> m_busy[LaneCount] {};
+    std::atomic<unsigned> m_nextWorker[LaneCount] {};       // round robin for submissions
+    std::atomic<bool> m_stop {false};
+
+    std::mutex m_idleMutex;
+    std::condition_variable m_workAvailable[LaneCount];
+
+    void submit(TaskGroup *group, Priority priority, Lane lane, std::function<void()> task);
+    int remove(TaskGroup *group); // queued tasks of the group, returns how many
+    bool take(Lane lane, int id, Task &task);
+    void work(Lane lane, int id);
+};
+
+// The tasks one subsystem submits, so they can be dropped and waited for together without touching the
+// work of others. Queue depth and running tasks are reported to their Metrics pool.
+class TaskGroup {
+public:
+    explicit TaskGroup(Metrics::Pool pool, TaskScheduler &scheduler = TaskScheduler::instance());
+    ~TaskGroup(); // clears and waits, tasks may refer to the owner
+
+    void run(TaskScheduler::Priority priority, TaskScheduler::Lane lane, std::function<void()> task);
+    void clear(); // queued tasks are dropped, running ones finish
+    void waitForDone();
+    int outstanding() const; // queued and running
+
+private:
+    friend class TaskScheduler;
+
+    Metrics::Pool m_pool;
+    TaskScheduler &m_scheduler;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_done;
+    int m_outstanding = 0;
+
+    void finished(int tasks);
+};
@@ -0,0 +1,141 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailcache.h"
+
+void ThumbnailCache::clear() {
+    m_links.clear();
+    m_head = None;
+    m_tail = None;
+    m_size = 0;
+    m_memoryBytes = 0;
+    m_diskBytes = 0;
+    m_measured = 0;
+    m_measuredBytes = 0;
+}
+
+void ThumbnailCache::resize(int rows) {
+    if (rows < int(m_links.size())) {
+        // Drop resident rows that no longer exist
+        for (int row = rows; row < int(m_links.size()); ++row)
+            remove(row);
+    }
+    m_links.resize(rows);
+}
+
+void ThumbnailCache::remap(const std::vector<int> &newRows, int rows) {
+    std::vector<Link> links(rows);
+    int32_t head = None;
+    int32_t tail = None;
+
+    // Relink from most to least recently used
+    for (int32_t row = m_head; row != None;) {
+        const Link link = m_links[row];
+        const int target = row < int(newRows.size()) ? newRows[row] : -1;
+        row = link.next;
+
+        if (target < 0 || target >= rows) {
+            m_memoryBytes -= link.memoryBytes;
+            m_diskBytes -= link.diskBytes;
+            if (link.measured) {
+                --m_measured;
+                m_measuredBytes -= link.memoryBytes;
+            }
+            --m_size;
+            continue;
+        }
+
+        links[target] = link;
+        links[target].prev = tail;
+        links[target].next = None;
+        if (tail != None) links[tail].next = target;
+        else head = target;
+        tail = target;
+    }
+
+    m_links.swap(links);
+    m_head = head;
+    m_tail = tail;
+}
+
+void ThumbnailCache::touch(int row, int64_t estimatedBytes) {
+    if (row < 0 || row >= int(m_links.size())) return;
+    if (m_head == row) return;
+
+    Link &link = m_links[row];
+    if (link.resident) unlink(row);
+    else {
+        // Pending thumbnails count with an estimate until their real size is known
+        link.resident = true;
+        link.memoryBytes = estimatedBytes;
+        m_memoryBytes += estimatedBytes;
+        ++m_size;
+    }
+
+    link.prev = None;
+    link.next = m_head;
+    if (m_head != None) m_links[m_head].prev = row;
+    m_head = row;
+    if (m_tail == None) m_tail = row;
+}
+
+void ThumbnailCache::remove(int row) {
+    if (!contains(row)) return;
+    unlink(row);
+    const Link &link = m_links[row];
+    m_memoryBytes -= link.memoryBytes;
+    m_diskBytes -= link.diskBytes;
+    if (link.measured) {
+        --m_measured;
+        m_measuredBytes -= link.memoryBytes;
+    }
+    m_links[row] = Link();
+    --m_size;
+}
+
+void ThumbnailCache::setBytes(int row, int64_t memoryBytes, int64_t diskBytes) {
+    if (!contains(row)) return;
+    Link &link = m_links[row];
+    if (link.measured) m_measuredBytes -= link.memoryBytes;
+    else ++m_measured;
+    m_measuredBytes += memoryBytes;
+
+    m_memoryBytes += memoryBytes - link.memoryBytes;
+    m_diskBytes += diskBytes - link.diskBytes;
+    link.measured = true;
+    link.memoryBytes = memoryBytes;
+    link.diskBytes = diskBytes;
+}
+
+void ThumbnailCache::unlink(int row) {
+    Link &link = m_links[row];
+    if (link.prev != None) m_links[link.prev].next = link.next;
+    else m_head = link.next;
+    if (link.next != None) m_links[link.next].prev = link.prev;
+    else m_tail = link.prev;
+    link.prev = None;
+    link.next = None;
+}
+
+std::vector<int> ThumbnailCache::rows() const {
+    std::vector<int> result;
+    result.reserve(m_size);
+    for (int row = m_tail; row != None; row = m_links[row].prev)
+        result.push_back(row);
+    return result;
+}
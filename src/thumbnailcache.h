@@ -0,0 +1,80 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Intrusive LRU list of resident thumbnails, indexed by source row.
+// All operations are O(1), iteration only visits resident rows.
+// Tracks decoded (memory) and file (disk) bytes of the resident set against one byte budget.
+class ThumbnailCache {
+public:
+    void clear();
+    void resize(int rows);
+    void remap(const std::vector<int> &newRows, int rows); // newRows[row] is the new row or -1, keeps the LRU order
+
+    bool contains(int row) const { return row >= 0 && row < int(m_links.size()) && m_links[row].resident; }
+    int size() const { return m_size; }
+
+    void touch(int row, int64_t estimatedBytes = 0);  // insert or mark as most recently used
+    void remove(int row);
+    void setBytes(int row, int64_t memoryBytes, int64_t diskBytes);
+
+    void setBudget(int64_t bytes) { m_budget = bytes; }
+    int64_t budget() const { return m_budget; }
+    int64_t memoryBytes() const { return m_memoryBytes; }
+    int64_t diskBytes() const { return m_diskBytes; }
+    bool overBudget() const { return m_memoryBytes > m_budget || m_diskBytes > m_budget; }
+    int64_t averageMemoryBytes() const { return m_measured > 0 ? m_measuredBytes / m_measured : 0; }
+
+    // Hit rate of thumbnails that were already available when they became visible
+    void recordLookup(bool hit) { ++m_lookups; if (hit) ++m_hits; }
+    double hitRate() const { return m_lookups > 0 ? double(m_hits) / double(m_lookups) : 0.0; }
+    int64_t lookups() const { return m_lookups; }
+
+    int leastRecent() const { return m_tail; }
+    int moreRecent(int row) const { return m_links[row].prev; }
+    std::vector<int> rows() const; // least recently used first
+
+private:
+    static constexpr int32_t None = -1;
+    struct Link {
+        int32_t prev = None; // towards most recently used
+        int32_t next = None; // towards least recently used
+        bool resident = false;
+        bool measured = false;
+        int64_t memoryBytes = 0;
+        int64_t diskBytes = 0;
+    };
+
+    std::vector<Link> m_links;
+    int32_t m_head = None; // most recently used
+    int32_t m_tail = None; // least recently used
+    int m_size = 0;
+
+    int64_t m_budget = 0;
+    int64_t m_memoryBytes = 0;
+    int64_t m_diskBytes = 0;
+    int64_t m_measured = 0;      // resident thumbnails with known size, for the per-thumbnail estimate
+    int64_t m_measuredBytes = 0;
+    int64_t m_lookups = 0;
+    int64_t m_hits = 0;
+
+    void unlink(int row);
+};
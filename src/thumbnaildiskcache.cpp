@@ -0,0 +1,80 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+#include "thumbnaildiskcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <vector>
+
+QString ThumbnailDiskCache::location() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+QString ThumbnailDiskCache::file(const QString &filePath, qint64 fileSize, qint64 modified, int targetShort) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(filePath.toUtf8());
+    hash.addData(QByteArray::number(fileSize) + ':' + QByteArray::number(modified) + ':' + QByteArray::number(targetShort));
+    const QString name = QString::fromLatin1(hash.result().toHex());
+
+    // Spread over 256 directories, so none grows to the size of the whole library
+    return location() + '/' + name.left(2) + '/' + name + ".jpg";
+}
+
+qint64 ThumbnailDiskCache::store(const QImage &thumbnail, const QString &file) {
+    if (!QDir().mkpath(QFileInfo(file).absolutePath())) return -1;
+
+    QSaveFile target(file);
+    if (!target.open(QIODevice::WriteOnly) || !thumbnail.save(&target, "JPG")) return -1;
+    const qint64 bytes = target.size();
+    return target.commit() ? bytes : -1;
+}
+
+void ThumbnailDiskCache::touch(const QString &file) {
+    QFile entry(file);
+    if (entry.open(QIODevice::ReadWrite)) entry.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+}
+
+void ThumbnailDiskCache::trim(qint64 maxBytes) {
+    struct Entry {
+        qint64 used;
+        qint64 bytes;
+        QString path;
+    };
+    std::vector<Entry> entries;
+    qint64 total = 0;
+    QDirIterator it(location(), {"*.jpg"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        entries.push_back({ info.lastModified().toMSecsSinceEpoch(), info.size(), info.filePath() });
+        total += info.size();
+    }
+    if (total <= maxBytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    for (const Entry &entry : entries) {
+        if (total <= maxBytes) break;
+        if (QFile::remove(entry.path)) total -= entry.bytes;
+    }
+}
@@ -0,0 +1,34 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <QImage>
+#include <QString>
+
+// Thumbnails kept across sessions under the cache location, apart from the memory budget of the open album.
+// Each thumbnail is written once, here, and gallery rows show the cache file itself.
+// Entries are keyed by photo path, size, modification time and resolution, so an edited photo misses instead of
+// showing a stale image. Entries are written under a temporary name and renamed, readers never see partial files.
+class ThumbnailDiskCache {
+public:
+    static QString location();
+    static QString file(const QString &filePath, qint64 fileSize, qint64 modified, int targetShort); // may not exist
+
+    static qint64 store(const QImage &thumbnail, const QString &file); // encoded as JPEG, the bytes written or -1
+    static void touch(const QString &file);                             // used again, trimmed last
+    static void trim(qint64 maxBytes);                                  // least recently used entries first
+};
@@ -17,44 +17,103 @@
 */
 
 #include "thumbnailworker.h"
-#include <QtConcurrent>
+#include "tracing.h"
+#include "metrics.h"
+#include "thumbnaildiskcache.h"
 #include <QImageReader>
-#include <QDir>
+#include <QFileInfo>
 #include <QDebug>
 
-ThumbnailWorker::ThumbnailWorker(const QString &tempPath, int targetShort, QObject *parent) : QObject(parent), m_tempPath(tempPath), m_targetShort(targetShort) {}
+ThumbnailWorker::ThumbnailWorker(int targetShort, QObject *parent) : QObject(parent), m_targetShort(targetShort) {}
 ThumbnailWorker::~ThumbnailWorker() {
-    m_threadPool.clear();
-    m_threadPool.waitForDone();
+    m_tasks.clear();
+    m_tasks.waitForDone();
 }
 
-void ThumbnailWorker::requestThumbnail(int index, QString filePath) {
-    QFuture<void> future = QtConcurrent::run(&m_threadPool, [=]() {
-        QImageReader reader(filePath);
-        reader.setAutoTransform(true);
-        QImage img = reader.read();
-        if (img.isNull()) return;
-
-        // Scale so the shorter side = 200px, keeping aspect ratio
-        int w = img.width();
-        int h = img.height();
-        int targetShort = m_targetShort;
-        QSize scaledSize = (w < h)
-                        ? QSize(targetShort, targetShort * h / w)
-                        : QSize(targetShort * w / h, targetShort);
-        QImage thumb = img.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        QString thumbDirPath = m_tempPath + "/thumbnails";
-        QDir tempDir(thumbDirPath);
-
-        if (!tempDir.exists() && !tempDir.mkpath(".")) {
-            qWarning() << "Failed to create temp directory:" << tempDir.path();
+void ThumbnailWorker::cancelPending() {
+    m_cancellation.cancel();
+    m_cancellation = CancellationToken();
+    m_tasks.clear();
+}
+
+void ThumbnailWorker::requestThumbnail(int index, QString filePath, qint64 fileSize, qint64 modified, bool visible) {
+    const CancellationToken cancellation = m_cancellation;
+    const TaskScheduler::Priority priority = visible ? TaskScheduler::Visible : TaskScheduler::Prefetch;
+    const int targetShort = m_targetShort;
+    m_tasks.run(priority, TaskScheduler::CpuLane, [=]() {
+        if (cancellation.isCancelled()) return;
+        LYSA_TRACE_SCOPE("thumbnail", "ThumbnailWorker::generate");
+
+        // Generated in an earlier session or by lysa --index, the row shows the cache file itself
+        const QString cached = ThumbnailDiskCache::file(filePath, fileSize, modified, targetShort);
+        const QFileInfo info(cached);
+        if (info.exists()) {
+            ThumbnailDiskCache::touch(cached);
+            const QSize size = QImageReader(cached).size();
+            Metrics::count(Metrics::ThumbnailsCached);
+            emit thumbnailReady(index, filePath, modified, targetShort, qint64(size.width()) * size.height() * 4, info.size());
             return;
         }
 
-        QString thumbPath = tempDir.filePath("thumb_" + QUuid::createUuid().toString(QUuid::Id128) + ".jpg");
-        thumb.save(thumbPath, "JPG");
-        emit thumbnailReady(index, thumbPath);
+        const QImage thumb = generate(filePath, targetShort);
+        if (thumb.isNull() || cancellation.isCancelled()) return;
+        qint64 diskBytes;
+        {
+            LYSA_TRACE_SCOPE("thumbnail", "QImage::save");
+            diskBytes = ThumbnailDiskCache::store(thumb, cached);
+        }
+        if (diskBytes < 0) {
+            qWarning() << "Failed to write thumbnail:" << cached;
+            return;
+        }
+        Metrics::count(Metrics::ThumbnailsGenerated);
+        emit thumbnailReady(index, filePath, modified, targetShort, thumb.sizeInBytes(), diskBytes);
     });
 
-}
\ No newline at end of file
+}
+
+void ThumbnailWorker::cacheThumbnail(QString filePath, qint64 fileSize, qint64 modified) {
+    const CancellationToken cancellation = m_cancellation;
+    const int targetShort = m_targetShort;
+    m_tasks.run(TaskScheduler::Background, TaskScheduler::CpuLane, [=]() {
+        if (cancellation.isCancelled()) return;
+        const QString cached = ThumbnailDiskCache::file(filePath, fileSize, modified, targetShort);
+        if (QFileInfo::exists(cached)) {
+            Metrics::count(Metrics::ThumbnailsCached);
+            return;
+        }
+        LYSA_TRACE_SCOPE("thumbnail", "ThumbnailWorker::cache");
+
+        const QImage thumb = generate(filePath, targetShort);
+        if (thumb.isNull() || ThumbnailDiskCache::store(thumb, cached) < 0) return;
+        Metrics::count(Metrics::ThumbnailsGenerated);
+    });
+}
+
+void ThumbnailWorker::trimDiskCache(qint64 maxBytes) {
+    m_tasks.run(TaskScheduler::Background, TaskScheduler::IoLane, [maxBytes]() {
+        LYSA_TRACE_SCOPE("thumbnail", "ThumbnailDiskCache::trim");
+        ThumbnailDiskCache::trim(maxBytes);
+    });
+}
+
+QImage ThumbnailWorker::generate(const QString &filePath, int targetShort) const {
+    QImage img;
+    {
+        LYSA_TRACE_SCOPE("thumbnail", "QImageReader::read");
+        Metrics::LatencyScope latency(Metrics::ThumbnailDecode);
+        QImageReader reader(filePath);
+        reader.setAutoTransform(true);
+        img = reader.read();
+    }
+    if (img.isNull()) return {};
+
+    // Scale so the shorter side = 200px, keeping aspect ratio
+    int w = img.width();
+    int h = img.height();
+    QSize scaledSize = (w < h)
+                    ? QSize(targetShort, targetShort * h / w)
+                    : QSize(targetShort * w / h, targetShort);
+    LYSA_TRACE_SCOPE("thumbnail", "QImage::scaled");
+    return img.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
@@ -17,23 +17,31 @@
 */
 
 #pragma once
+#include <QImage>
 #include <QObject>
-#include <QThreadPool>
+#include "cancellationtoken.h"
+#include "taskscheduler.h"
 
 class ThumbnailWorker : public QObject {
     Q_OBJECT
 public:
-    ThumbnailWorker(const QString &tempPath, int targetShort, QObject *parent=nullptr);
+    ThumbnailWorker(int targetShort, QObject *parent=nullptr);
     ~ThumbnailWorker();
-    void requestThumbnail(int index, QString filePath);
-    int targetSize() { return m_targetShort; }
+    // From the disk cache when it has the photo at the current size and modification time, visible ones before prefetching
+    void requestThumbnail(int index, QString filePath, qint64 fileSize, qint64 modified, bool visible = false);
+    void cacheThumbnail(QString filePath, qint64 fileSize, qint64 modified); // only into the disk cache, behind everything else
+    void trimDiskCache(qint64 maxBytes);
+    void cancelPending(); // queued requests are dropped, running ones finish without reporting
+    int targetSize() const { return m_targetShort; }
     void setTargetSize(int targetShort) { m_targetShort = targetShort; }
 
 signals:
-    void thumbnailReady(int index, QString thumbPath);
+    void thumbnailReady(int index, QString filePath, qint64 modified, int targetShort, qint64 memoryBytes, qint64 diskBytes); // the file is in the disk cache
 
 private:
-    QThreadPool m_threadPool;
+    TaskGroup m_tasks { Metrics::ThumbnailPool };
     int m_targetShort;
-    QString m_tempPath;
+    CancellationToken m_cancellation;
+
+    QImage generate(const QString &filePath, int targetShort) const; // null if the photo cannot be read
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "timelineindex.h"
+#include <algorithm>
+
+void TimelineIndex::clear() {
+    for (int g = Year; g <= Day; ++g) {
+        m_buckets[g].clear();
+        m_lookup[g].clear();
+    }
+}
+
+void TimelineIndex::rebuild(const std::vector<uint32_t> &rows, const std::vector<int32_t> &dayKeys) {
+    clear();
+
+    static const int32_t divisors[3] = { 10000, 100, 1 };
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const uint32_t sourceRow = rows[row];
+        const int32_t day = sourceRow < dayKeys.size() ? dayKeys[sourceRow] : 0;
+        if (day == 0) continue; // unknown date, not part of any bucket
+
+        for (int g = Year; g <= Day; ++g) {
+            const int32_t key = day / divisors[g];
+            std::vector<Bucket> &buckets = m_buckets[g];
+
+            // Extend the current run or start a new one
+            if (!buckets.empty() && buckets.back().key == key && buckets.back().firstRow + buckets.back().count == int(row)) {
+                ++buckets.back().count;
+                continue;
+            }
+            if (!m_lookup[g].contains(key))
+                m_lookup[g].insert(key, int(buckets.size()));
+            buckets.push_back({ key, int(row), 1 });
+        }
+    }
+}
+
+int TimelineIndex::firstRow(int year, int month, int day) const {
+    Granularity granularity = Year;
+    int32_t key = year;
+    if (month > 0) {
+        granularity = Month;
+        key = key * 100 + month;
+        if (day > 0) {
+            granularity = Day;
+            key = key * 100 + day;
+        }
+    }
+
+    const int bucket = m_lookup[granularity].value(key, -1);
+    return bucket < 0 ? -1 : m_buckets[granularity][bucket].firstRow;
+}
+
+int TimelineIndex::bucketAt(Granularity granularity, int row) const {
+    const std::vector<Bucket> &buckets = m_buckets[granularity];
+    auto it = std::upper_bound(buckets.begin(), buckets.end(), row,
+        [](int value, const Bucket &bucket) { return value < bucket.firstRow; });
+    if (it == buckets.begin()) return buckets.empty() ? -1 : 0;
+    return int(std::distance(buckets.begin(), it)) - 1;
+}
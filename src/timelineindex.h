@@ -0,0 +1,48 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QDate>
+#include <QHash>
+#include <vector>
+#include <cstdint>
+
+// Cumulative row counts per year/month/day over a date-sorted row order
+class TimelineIndex {
+public:
+    enum Granularity { Year, Month, Day };
+
+    struct Bucket {
+        int32_t key;  // yyyy, yyyymm or yyyymmdd
+        int firstRow; // rows before this bucket
+        int count;
+    };
+
+    static int32_t dayKey(const QDate &date) { return date.isValid() ? date.year() * 10000 + date.month() * 100 + date.day() : 0; }
+
+    void clear();
+    void rebuild(const std::vector<uint32_t> &rows, const std::vector<int32_t> &dayKeys);
+
+    const std::vector<Bucket>& buckets(Granularity granularity) const { return m_buckets[granularity]; }
+    int firstRow(int year, int month = 0, int day = 0) const;
+    int bucketAt(Granularity granularity, int row) const;
+
+private:
+    std::vector<Bucket> m_buckets[3];
+    QHash<int32_t, int> m_lookup[3]; // key -> bucket index of its first run
+};
@@ -0,0 +1,191 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSaveFile>
+#include <QThread>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Tracer::s_enabled {false};
+
+namespace {
+
+struct Event {
+    const char *category;
+    const char *name;
+    int64_t start;
+    int64_t end;
+};
+
+// Events are appended to a list of fixed-size chunks. Only the owning thread writes, the exporter
+// reads up to the published count of each chunk, so neither side ever waits for the other.
+struct Chunk {
+    static constexpr int Size = 4096;
+    Event events[Size];
+    std::atomic<int> count {0};
+    std::atomic<Chunk*> next {nullptr};
+};
+
+struct ThreadBuffer {
+    static constexpr int MaxChunks = 256; // 1M events, about 32 MB per thread
+
+    int id = 0;
+    QString name;
+    Chunk head;
+    Chunk *tail = &head; // owning thread only
+    int chunks = 1;
+    std::atomic<int64_t> dropped {0};
+
+    ~ThreadBuffer() {
+        for (Chunk *chunk = head.next.load(); chunk;) {
+            Chunk *next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+};
+
+// Buffers outlive their threads so spans of finished pool threads still make it into the export
+std::mutex s_registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+std::atomic<int64_t> s_origin {0};
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+ThreadBuffer* threadBuffer() {
+    if (t_buffer) return t_buffer;
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    QThread *thread = QThread::currentThread();
+    const bool mainThread = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    buffer->id = int(s_buffers.size()) + 1;
+    if (mainThread) buffer->name = QStringLiteral("GUI thread");
+    else if (thread && !thread->objectName().isEmpty()) buffer->name = QStringLiteral("%1 %2").arg(thread->objectName()).arg(buffer->id);
+    else buffer->name = QStringLiteral("Thread %1").arg(buffer->id);
+    t_buffer = buffer.get();
+    s_buffers.push_back(std::move(buffer));
+    return t_buffer;
+}
+
+void appendJsonString(QByteArray &out, const char *text) {
+    out += '"';
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        out += *c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+void Tracer::setEnabled(bool enabled) {
+    int64_t unset = 0;
+    if (enabled) s_origin.compare_exchange_strong(unset, now());
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *category, const char *name, int64_t start, int64_t end) {
+    ThreadBuffer *buffer = threadBuffer();
+    Chunk *chunk = buffer->tail;
+    int count = chunk->count.load(std::memory_order_relaxed);
+
+    if (count == Chunk::Size) {
+        if (buffer->chunks == ThreadBuffer::MaxChunks) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Chunk *next = new Chunk;
+        chunk->next.store(next, std::memory_order_release);
+        buffer->tail = chunk = next;
+        ++buffer->chunks;
+        count = 0;
+    }
+
+    chunk->events[count] = { category, name, start, end };
+    chunk->count.store(count + 1, std::memory_order_release);
+}
+
+bool Tracer::writeChromeTrace(const QString &filePath) {
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        for (const auto &buffer : s_buffers)
+            buffers.push_back(buffer.get());
+    }
+
+    const int64_t origin = s_origin.load();
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]() {
+        if (!first) out += ",\n";
+        first = false;
+    };
+
+    for (ThreadBuffer *buffer : buffers) {
+        separate();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid)
+             + ",\"tid\":" + QByteArray::number(buffer->id)
+             + ",\"args\":{\"name\":";
+        appendJsonString(out, buffer->name.toUtf8().constData());
+        out += "}}";
+
+        for (Chunk *chunk = &buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const int count = chunk->count.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i) {
+                const Event &event = chunk->events[i];
+                separate();
+                out += "{\"name\":";
+                appendJsonString(out, event.name);
+                out += ",\"cat\":";
+                appendJsonString(out, event.category);
+                out += ",\"ph\":\"X\",\"ts\":" + QByteArray::number(double(event.start - origin) / 1000.0, 'f', 3)
+                     + ",\"dur\":" + QByteArray::number(double(event.end - event.start) / 1000.0, 'f', 3)
+                     + ",\"pid\":" + QByteArray::number(pid)
+                     + ",\"tid\":" + QByteArray::number(buffer->id) + "}";
+            }
+        }
+
+        const int64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0) qWarning() << "Trace buffer of" << buffer->name << "was full," << dropped << "spans dropped";
+    }
+    out += "]}\n";
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write trace file:" << filePath << file.errorString();
+        return false;
+    }
+    file.write(out);
+    if (!file.commit()) {
+        qWarning() << "Could not write trace file:" << filePath << file.errorString();
+        return false;
+    }
+    qInfo() << "Wrote performance trace to" << filePath;
+    return true;
+}
@@ -0,0 +1,64 @@
+/*
+* Lysa - Photo Organizer
+* Copyright (C) 2025 vorks. DEV (Jeremy Voß)
+* 
+* This file is part of Lysa.
+* 
+* Lysa is free software: you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License version 3
+* as published by the Free Software Foundation.
+* 
+* Lysa is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+* You should have received a copy of the GNU General Public License 
+* along with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+// Scoped trace spans for finding out where the time goes. Each thread appends complete events to its own
+// buffer without locking, a disabled tracer costs one relaxed load per span. Names and categories must be
+// string literals, the buffers keep the pointers. writeChromeTrace() exports everything recorded so far in
+// the Chrome trace event format, to be opened in chrome://tracing or ui.perfetto.dev.
+class Tracer {
+public:
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    static int64_t now(); // nanoseconds on a monotonic clock
+    static void record(const char *category, const char *name, int64_t start, int64_t end);
+    static bool writeChromeTrace(const QString &filePath);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+class TraceScope {
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category), m_name(name), m_start(Tracer::enabled() ? Tracer::now() : -1) {}
+    ~TraceScope() {
+        if (m_start >= 0) Tracer::record(m_category, m_name, m_start, Tracer::now());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope& operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_category;
+    const char *m_name;
+    int64_t m_start;
+};
+
+#define LYSA_TRACE_CONCAT_(a, b) a##b
+#define LYSA_TRACE_CONCAT(a, b) LYSA_TRACE_CONCAT_(a, b)
+#ifdef LYSA_NO_TRACING
+#define LYSA_TRACE_SCOPE(category, name) do {} while (false)
+#else
+#define LYSA_TRACE_SCOPE(category, name) TraceScope LYSA_TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+#endif